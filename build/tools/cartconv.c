@@ -0,0 +1,397 @@
+// MIT License
+
+// Copyright (c) 2020 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Converts many carts and projects at once on a pool of worker threads.
+//
+// usage: cartconv [-j threads] [-z] <manifest> | <directory> <ext>
+//
+// -z deflates the cart chunks, such carts don't load in older TIC-80 versions.
+// Every manifest line is "<input> <output>", a directory converts all the
+// carts and projects in it to the files with the given extension near them.
+// The direction depends on the file extensions, a .wasmp project takes the
+// .wasm file with the same name as its binary chunk.
+
+#include "cart.h"
+#include "tools.h"
+#include "studio/project.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(USE_LIBUV)
+#include <uv.h>
+#endif
+
+#define FILENAME_LEN 1023
+
+typedef struct
+{
+	char* input;
+	char* output;
+
+	bool done;
+	s32 inputSize;
+	s32 outputSize;
+	u64 time;
+} Job;
+
+typedef struct
+{
+	Job* items;
+	s32 count;
+	s32 capacity;
+	s32 next;
+	bool packed;
+
+#if defined(USE_LIBUV)
+	uv_mutex_t lock;
+#endif
+} JobList;
+
+// buffers are owned by a worker and reused for all its files
+typedef struct
+{
+	JobList* jobs;
+	tic_cartridge* cart;
+	u8* input;
+	s32 inputCapacity;
+	u8* output;
+} Worker;
+
+static u64 now()
+{
+#if defined(USE_LIBUV)
+	return uv_hrtime();
+#else
+	return (u64)clock() * 1000000000 / CLOCKS_PER_SEC;
+#endif
+}
+
+static void addJob(JobList* jobs, const char* input, const char* output)
+{
+	if(jobs->count == jobs->capacity)
+	{
+		jobs->capacity = jobs->capacity ? jobs->capacity * 2 : 256;
+		jobs->items = realloc(jobs->items, jobs->capacity * sizeof(Job));
+	}
+
+	jobs->items[jobs->count++] = (Job){strdup(input), strdup(output)};
+}
+
+static bool isCart(const char* name)
+{
+	return tic_tool_has_ext(name, ".tic");
+}
+
+static bool readFile(Worker* worker, const char* name, s32* size)
+{
+	FILE* file = fopen(name, "rb");
+
+	if(!file)
+		return false;
+
+	fseek(file, 0, SEEK_END);
+	*size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	if(*size + 1 > worker->inputCapacity)
+	{
+		worker->inputCapacity = *size + 1;
+		worker->input = realloc(worker->input, worker->inputCapacity);
+	}
+
+	bool done = fread(worker->input, *size, 1, file) == 1 || *size == 0;
+	fclose(file);
+
+	return done;
+}
+
+static bool loadBinary(Worker* worker, const char* project)
+{
+	char* name = malloc(strlen(project) + 1);
+	strcpy(name, project);
+	name[strlen(name) - 1] = '\0'; // .wasmp -> .wasm
+
+	s32 size = 0;
+	bool done = false;
+
+	if(!readFile(worker, name, &size))
+		fprintf(stderr, "cannot open %s\n", name);
+	else if(size > TIC_BINARY_SIZE)
+		fprintf(stderr, "%s is %i bytes, the binary can't be more than %i\n", name, size, TIC_BINARY_SIZE);
+	else
+	{
+		memcpy(worker->cart->binary.data, worker->input, size);
+		worker->cart->binary.size = size;
+		done = true;
+	}
+
+	free(name);
+
+	return done;
+}
+
+static bool convert(Worker* worker, Job* job)
+{
+	tic_cartridge* cart = worker->cart;
+
+	if(!readFile(worker, job->input, &job->inputSize))
+	{
+		fprintf(stderr, "cannot open %s\n", job->input);
+		return false;
+	}
+
+	if(isCart(job->input))
+		tic_cart_load(cart, worker->input, job->inputSize);
+	else
+	{
+		memset(cart, 0, sizeof(tic_cartridge));
+
+		if(!tic_project_load(job->input, (const char*)worker->input, job->inputSize, cart))
+		{
+			fprintf(stderr, "cannot load project %s\n", job->input);
+			return false;
+		}
+
+		if(tic_tool_has_ext(job->input, ".wasmp") && !loadBinary(worker, job->input))
+			return false;
+	}
+
+	job->outputSize = isCart(job->output)
+		? (worker->jobs->packed ? tic_cart_save_packed : tic_cart_save)(cart, worker->output)
+		: tic_project_save(job->output, worker->output, cart);
+
+	FILE* file = fopen(job->output, "wb");
+
+	if(!file)
+	{
+		fprintf(stderr, "cannot open %s\n", job->output);
+		return false;
+	}
+
+	bool done = fwrite(worker->output, job->outputSize, 1, file) == 1;
+	fclose(file);
+
+	return done;
+}
+
+static Job* nextJob(JobList* jobs)
+{
+	Job* job = NULL;
+
+#if defined(USE_LIBUV)
+	uv_mutex_lock(&jobs->lock);
+#endif
+
+	if(jobs->next < jobs->count)
+		job = &jobs->items[jobs->next++];
+
+#if defined(USE_LIBUV)
+	uv_mutex_unlock(&jobs->lock);
+#endif
+
+	return job;
+}
+
+static void work(void* data)
+{
+	Worker* worker = data;
+
+	for(Job* job = nextJob(worker->jobs); job; job = nextJob(worker->jobs))
+	{
+		u64 start = now();
+		job->done = convert(worker, job);
+		job->time = now() - start;
+	}
+}
+
+static bool loadManifest(JobList* jobs, const char* path)
+{
+	FILE* file = fopen(path, "r");
+
+	if(!file)
+		return false;
+
+	char line[2 * FILENAME_LEN + 16], input[FILENAME_LEN + 1], output[FILENAME_LEN + 1];
+
+	while(fgets(line, sizeof line, file))
+		if(sscanf(line, "%" DEF2STR(FILENAME_LEN) "s %" DEF2STR(FILENAME_LEN) "s", input, output) == 2)
+			addJob(jobs, input, output);
+
+	fclose(file);
+
+	return true;
+}
+
+#if defined(USE_LIBUV)
+static bool loadDir(JobList* jobs, const char* path, const char* ext)
+{
+	uv_fs_t req;
+
+	if(uv_fs_scandir(NULL, &req, path, 0, NULL) < 0)
+	{
+		uv_fs_req_cleanup(&req);
+		return false;
+	}
+
+	uv_dirent_t entry;
+	while(uv_fs_scandir_next(&req, &entry) != UV_EOF)
+	{
+		if(entry.type == UV_DIRENT_DIR
+			|| !(isCart(entry.name) || tic_project_ext(entry.name))
+			|| tic_tool_has_ext(entry.name, ext))
+			continue;
+
+		char input[FILENAME_LEN + 1], output[FILENAME_LEN + 1];
+		snprintf(input, sizeof input, "%s/%s", path, entry.name);
+		snprintf(output, sizeof output, "%s", input);
+
+		char* dot = strrchr(output, '.');
+		snprintf(dot, sizeof output - (dot - output), "%s", ext);
+
+		addJob(jobs, input, output);
+	}
+
+	uv_fs_req_cleanup(&req);
+
+	return true;
+}
+#endif
+
+int main(int argc, char** argv)
+{
+	s32 threads = 0;
+	bool packed = false;
+	const char* args[2] = {NULL};
+	s32 argsCount = 0;
+
+	for(s32 i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-z") == 0)
+			packed = true;
+		else if(argsCount < 2)
+			args[argsCount++] = argv[i];
+	}
+
+	if(argsCount == 0)
+	{
+		printf("usage: cartconv [-j threads] [-z] <manifest> | <directory> <ext>\n");
+		return -1;
+	}
+
+	JobList jobs = {.packed = packed};
+
+#if defined(USE_LIBUV)
+	if(!(args[1] && loadDir(&jobs, args[0], args[1])))
+#endif
+	if(!loadManifest(&jobs, args[0]))
+	{
+		printf("cannot open %s\n", args[0]);
+		return -1;
+	}
+
+#if defined(USE_LIBUV)
+	if(threads <= 0)
+	{
+		uv_cpu_info_t* cpus;
+		if(uv_cpu_info(&cpus, &threads) == 0)
+			uv_free_cpu_info(cpus, threads);
+	}
+#endif
+
+	threads = CLAMP(threads, 1, MAX(jobs.count, 1));
+
+	Worker* workers = calloc(threads, sizeof(Worker));
+
+	for(s32 i = 0; i < threads; i++)
+		workers[i] = (Worker)
+		{
+			.jobs = &jobs,
+			.cart = malloc(sizeof(tic_cartridge)),
+			.output = malloc(sizeof(tic_cartridge) * 3),
+		};
+
+	u64 start = now();
+
+#if defined(USE_LIBUV)
+	uv_mutex_init(&jobs.lock);
+	uv_thread_t* ids = malloc(threads * sizeof(uv_thread_t));
+
+	s32 started = 0;
+
+	while(started < threads && uv_thread_create(&ids[started], work, &workers[started]) == 0)
+		started++;
+
+	// the jobs are shared, so the calling thread takes the rest when no thread started
+	if(started == 0)
+		work(&workers[0]);
+
+	for(s32 i = 0; i < started; i++)
+		uv_thread_join(&ids[i]);
+
+	free(ids);
+	uv_mutex_destroy(&jobs.lock);
+#else
+	work(&workers[0]);
+#endif
+
+	u64 time = now() - start;
+	s64 inputTotal = 0, outputTotal = 0;
+	s32 failed = 0;
+
+	for(s32 i = 0; i < jobs.count; i++)
+	{
+		const Job* job = &jobs.items[i];
+
+		if(job->done)
+		{
+			printf("%s -> %s: %i -> %i bytes, %.2fms\n", job->input, job->output, 
+				job->inputSize, job->outputSize, job->time / 1e6);
+
+			inputTotal += job->inputSize;
+			outputTotal += job->outputSize;
+		}
+		else failed++;
+
+		free(job->input);
+		free(job->output);
+	}
+
+	printf("%i files converted, %i failed, %lli -> %lli bytes, %.2fs on %i threads\n", 
+		jobs.count - failed, failed, (long long)inputTotal, (long long)outputTotal, time / 1e9, threads);
+
+	for(s32 i = 0; i < threads; i++)
+	{
+		free(workers[i].cart);
+		free(workers[i].input);
+		free(workers[i].output);
+	}
+
+	free(workers);
+	free(jobs.items);
+
+	return failed ? -1 : 0;
+}
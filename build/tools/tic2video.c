@@ -0,0 +1,284 @@
+// MIT License
+
+// Copyright (c) 2020 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Renders a cartridge headlessly as fast as possible and writes the frames
+// as YUV4MPEG2 (.y4m or "-" for stdout) or raw RGBA, plus optional WAV audio.
+//
+// The input script holds lines of "<frame> <gamepads> [<keyboard> [<x> <y> <buttons>]]",
+// the frame in decimal and the rest in hex, every line sets the input state from the
+// given frame on, '#' starts a comment.
+
+#include "tic80.h"
+#include "wave_writer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+typedef struct
+{
+	s32 frame;
+	tic80_input input;
+} InputEvent;
+
+typedef struct
+{
+	InputEvent* items;
+	s32 count;
+} InputScript;
+
+static void* readFile(const char* path, s32* size)
+{
+	FILE* file = fopen(path, "rb");
+	void* buffer = NULL;
+
+	if(file)
+	{
+		fseek(file, 0, SEEK_END);
+		*size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		buffer = malloc(*size + 1);
+
+		if(buffer && fread(buffer, *size, 1, file) == 1)
+			((char*)buffer)[*size] = '\0';
+		else
+		{
+			free(buffer);
+			buffer = NULL;
+		}
+
+		fclose(file);
+	}
+
+	return buffer;
+}
+
+static bool loadInput(const char* path, InputScript* script)
+{
+	s32 size = 0;
+	char* text = readFile(path, &size);
+
+	if(!text) return false;
+
+	s32 capacity = 0;
+	for(char* line = strtok(text, "\r\n"); line; line = strtok(NULL, "\r\n"))
+	{
+		char* comment = strchr(line, '#');
+		if(comment) *comment = '\0';
+
+		s32 frame;
+		u32 gamepads = 0, keyboard = 0, x = 0, y = 0, buttons = 0;
+
+		if(sscanf(line, "%d %x %x %x %x %x", &frame, &gamepads, &keyboard, &x, &y, &buttons) < 2)
+			continue;
+
+		if(script->count == capacity)
+		{
+			capacity = capacity ? capacity * 2 : 64;
+			script->items = realloc(script->items, capacity * sizeof(InputEvent));
+		}
+
+		InputEvent* event = &script->items[script->count++];
+		memset(event, 0, sizeof(InputEvent));
+		event->frame = frame;
+		event->input.gamepads.data = gamepads;
+		event->input.keyboard.data = keyboard;
+		event->input.mouse.x = x;
+		event->input.mouse.y = y;
+		event->input.mouse.btns = buttons;
+	}
+
+	free(text);
+	return true;
+}
+
+static bool hasExt(const char* name, const char* ext)
+{
+	size_t nameLen = strlen(name), extLen = strlen(ext);
+	return nameLen >= extLen && strcmp(name + nameLen - extLen, ext) == 0;
+}
+
+static inline u8 clampByte(s32 value)
+{
+	return value < 0 ? 0 : value > 255 ? 255 : value;
+}
+
+// full range BT.601, planar 4:4:4
+static void rgbaToYuv(const u8* rgba, s32 count, u8* yuv)
+{
+	u8* py = yuv;
+	u8* pu = py + count;
+	u8* pv = pu + count;
+
+	for(s32 i = 0; i < count; i++, rgba += 4)
+	{
+		s32 r = rgba[0], g = rgba[1], b = rgba[2];
+
+		*py++ = clampByte((77 * r + 150 * g + 29 * b + 128) >> 8);
+		*pu++ = clampByte(((-43 * r - 85 * g + 128 * b + 128) >> 8) + 128);
+		*pv++ = clampByte(((128 * r - 107 * g - 21 * b + 128) >> 8) + 128);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	s32 frames = 60 * TIC80_FRAMERATE;
+	bool border = false;
+	const char* inputPath = NULL;
+	const char* args[3] = {NULL};
+	s32 argsCount = 0;
+
+	for(s32 i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+			frames = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+			inputPath = argv[++i];
+		else if(strcmp(argv[i], "-b") == 0)
+			border = true;
+		else if(argsCount < 3)
+			args[argsCount++] = argv[i];
+	}
+
+	if(argsCount < 2 || frames <= 0)
+	{
+		fprintf(stderr, "usage: tic2video [-n frames] [-i input] [-b] <cartridge> <video.y4m|video.rgba|-> [audio.wav]\n");
+		return -1;
+	}
+
+	s32 cartSize = 0;
+	void* cart = readFile(args[0], &cartSize);
+
+	if(!cart)
+	{
+		fprintf(stderr, "cannot open cartridge file\n");
+		return -1;
+	}
+
+	InputScript script = {0};
+
+	if(inputPath && !loadInput(inputPath, &script))
+	{
+		fprintf(stderr, "cannot open input file\n");
+		free(cart);
+		return -1;
+	}
+
+	FILE* video = NULL;
+	bool stdOut = strcmp(args[1], "-") == 0;
+
+	if(stdOut)
+	{
+#if defined(_WIN32)
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+		video = stdout;
+	}
+	else video = fopen(args[1], "wb");
+
+	if(!video)
+	{
+		fprintf(stderr, "cannot open video file\n");
+		free(script.items);
+		free(cart);
+		return -1;
+	}
+
+	bool y4m = stdOut || !hasExt(args[1], ".rgba");
+	s32 width = border ? TIC80_FULLWIDTH : TIC80_WIDTH;
+	s32 height = border ? TIC80_FULLHEIGHT : TIC80_HEIGHT;
+	s32 pixels = width * height;
+
+	if(y4m)
+		fprintf(video, "YUV4MPEG2 W%i H%i F%i:1 Ip A1:1 C444 XCOLORRANGE=FULL\n", width, height, TIC80_FRAMERATE);
+
+	bool audio = args[2] && wave_open(TIC80_SAMPLERATE, args[2]);
+
+	if(args[2] && !audio)
+		fprintf(stderr, "cannot open audio file\n");
+
+	if(audio)
+		wave_enable_stereo();
+
+	tic80* tic = tic80_create(TIC80_SAMPLERATE, TIC80_PIXEL_COLOR_RGBA8888);
+	tic80_load(tic, cart, cartSize);
+
+	u8* rgba = malloc(pixels * sizeof(u32));
+	u8* yuv = malloc(pixels * 3);
+	tic80_input input = {0};
+	s32 res = 0;
+
+	for(s32 frame = 0, event = 0; frame < frames; frame++)
+	{
+		while(event < script.count && script.items[event].frame <= frame)
+			input = script.items[event++].input;
+
+		tic80_tick(tic, input);
+		tic80_sound(tic);
+
+		const u32* src = tic->screen + (border ? 0 : TIC80_MARGIN_TOP * TIC80_FULLWIDTH + TIC80_MARGIN_LEFT);
+		for(s32 row = 0; row < height; row++, src += TIC80_FULLWIDTH)
+			memcpy(rgba + row * width * sizeof(u32), src, width * sizeof(u32));
+
+		bool written;
+
+		if(y4m)
+		{
+			rgbaToYuv(rgba, pixels, yuv);
+			written = fputs("FRAME\n", video) >= 0 && fwrite(yuv, pixels * 3, 1, video) == 1;
+		}
+		else written = fwrite(rgba, pixels * sizeof(u32), 1, video) == 1;
+
+		if(!written)
+		{
+			fprintf(stderr, "cannot write video frame %i\n", frame);
+			res = -1;
+			break;
+		}
+
+		if(audio)
+			wave_write(tic->samples.buffer, tic->samples.count);
+	}
+
+	if(audio)
+		wave_close();
+
+	if(!stdOut)
+		fclose(video);
+	else fflush(video);
+
+	tic80_delete(tic);
+
+	free(yuv);
+	free(rgba);
+	free(script.items);
+	free(cart);
+
+	return res;
+}
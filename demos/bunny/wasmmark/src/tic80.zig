@@ -134,6 +134,7 @@ pub const raw = struct {
     extern fn spr(id: i32, x: i32, y: i32, trans_colors: ?[*]const u8, color_count: i32, scale: i32, flip: i32, rotate: i32, w: i32, h: i32) void;
     extern fn sync(mask: i32, bank: i32, tocart: bool) void;
     extern fn textri(x1: f32, y1: f32, x2: f32, y2: f32, x3: f32, y3: f32, u1: f32, v1: f32, u2: f32, v2: f32, u3: f32, v3: f32, texsrc: i32, trans_colors: ?[*]const u8, color_count: i32) void;
+    extern fn mesh(vertices: [*]const f32, count: i32, matrix: *const [16]f32, texsrc: i32, trans_colors: ?[*]const u8, color_count: i32, cull: bool) i32;
     extern fn tri(x1: f32, y1: f32, x2: f32, y2: f32, x3: f32, y3: f32, color: i32) void;
     extern fn trib(x1: f32, y1: f32, x2: f32, y2: f32, x3: f32, y3: f32, color: i32) void;
     extern fn time() f32;
@@ -271,6 +272,19 @@ pub fn textri(x1: f32, y1: f32, x2: f32, y2: f32, x3: f32, y3: f32, @"u1": f32,
     raw.textri(x1, y1, x2, y2, x3, y3, @"u1", v1, @"u2", v2, @"u3", v3, args.texsrc, trans_colors, color_count);
 }
 
+const MeshArgs = struct {
+    texsrc : i32 = 0,
+    transparent: []const u8 = .{},
+    cull: bool = false,
+};
+
+// vertices are x y z u v, every three of them make a triangle
+pub fn mesh(vertices: []const f32, matrix: *const [16]f32, args: MeshArgs) i32 {
+    const color_count = @intCast(u8,args.transparent.len);
+    const trans_colors = args.transparent.ptr;
+    return raw.mesh(vertices.ptr, @intCast(i32, vertices.len / 5), matrix, args.texsrc, trans_colors, color_count, args.cull);
+}
+
 // ----
 // TEXT
 
@@ -48,6 +48,14 @@ typedef struct
     void* data;
 } tic_tick_data;
 
+typedef enum
+{
+    tic_gc_auto,            // runtime default, collects on allocation
+    tic_gc_step,            // incremental steps in the frame slack after TIC()
+    tic_gc_generational,    // generational mode where the runtime supports it
+    tic_gc_off,
+} tic_gc_mode;
+
 typedef struct tic_mem tic_mem;
 typedef void(*tic_tick)(tic_mem* memory);
 typedef void(*tic_scanline)(tic_mem* memory, s32 row, void* data);
@@ -80,11 +88,17 @@ typedef struct
 
         tic_tick tick;
         tic_blit_callback callback;
+
+        // called after every TIC() with the rest of the frame time
+        void(*gc)(tic_mem* memory, clock_t budget);
     };
 
     const tic_outline_item* (*getOutline)(const char* code, s32* size);
     void (*eval)(tic_mem* tic, const char* code);
 
+    // applies code changes to the running VM, returns false if the cart has to be restarted
+    bool (*reload)(tic_mem* tic, const char* code);
+
     const char* blockCommentStart;
     const char* blockCommentEnd;
     const char* blockCommentStart2;
@@ -166,6 +180,10 @@ enum
 //      function parameters
 //  )
 
+// mesh() vertex is `x y z u v`, matrix is 4x4
+#define TIC_MESH_VERTEX 5
+#define TIC_MESH_MATRIX 16
+
 #define TIC_API_LIST(macro)                                                                                             \
     macro(print,                                                                                                        \
         "print(text x=0 y=0 color=15 fixed=false scale=1 smallfont=false) -> width",                                    \
@@ -701,6 +719,24 @@ enum
         float u1, float v1, float u2, float v2, float u3, float v3, tic_texture_src texsrc, u8* colors, s32 count)      \
                                                                                                                         \
                                                                                                                         \
+    macro(mesh,                                                                                                         \
+        "mesh(vertices matrix texsrc=0 chromakey=-1 cull=false) -> count",                                              \
+                                                                                                                        \
+        "It transforms a batch of 3D vertices by a matrix and renders them as textured triangles in one call.\n"        \
+        "The vertices are a flat list of `x y z u v` values, every three vertices make a triangle.\n"                   \
+        "The matrix is a list of 16 values in row-major order which maps a vertex to clip space, "                      \
+        "the result is divided by w and mapped to the screen.\n"                                                        \
+        "Triangles with a vertex behind the camera are skipped, with cull=true the back-facing ones too.\n"             \
+        "Triangles are drawn in the list order without depth test and perspective correction, see `textri()`.\n"        \
+        "It returns the number of drawn triangles.",                                                                    \
+        5,                                                                                                              \
+        2,                                                                                                              \
+        0,                                                                                                              \
+        s32,                                                                                                            \
+        tic_mem*, const float* vertices, s32 count, const float* matrix,                                                \
+        tic_texture_src texsrc, u8* colors, s32 colorsCount, bool cull)                                                 \
+                                                                                                                        \
+                                                                                                                        \
     macro(clip,                                                                                                         \
         "clip(x y width height)\nclip()",                                                                               \
                                                                                                                         \
@@ -838,12 +874,22 @@ struct tic_mem
 
         u8 data;
     } input;
+
+    struct
+    {
+        tic_gc_mode mode;
+
+        // collector stats after the last frame
+        clock_t time;
+        s32 heap;
+    } gc;
 };
 
 tic_mem* tic_core_create(s32 samplerate, tic80_pixel_color_format format);
 void tic_core_close(tic_mem* memory);
 void tic_core_pause(tic_mem* memory);
 void tic_core_resume(tic_mem* memory);
+bool tic_core_reload(tic_mem* memory);
 void tic_core_tick_start(tic_mem* memory);
 void tic_core_tick(tic_mem* memory, tic_tick_data* data);
 void tic_core_tick_end(tic_mem* memory);
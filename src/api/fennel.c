@@ -184,6 +184,7 @@ tic_script_config FennelSyntaxConfig =
     .init               = initFennel,
     .close              = closeLua,
     .tick               = callLuaTick,
+    .gc                 = collectLuaGarbage,
     .callback           =
     {
         .scanline       = callLuaScanline,
@@ -859,6 +859,77 @@ static duk_ret_t duk_textri(duk_context* duk)
     return 0;
 }
 
+static float* getDukFloats(duk_context* duk, duk_idx_t index, s32* count)
+{
+    *count = (s32)duk_get_length(duk, index);
+    float* values = malloc(*count * sizeof(float) + 1);
+
+    for(s32 i = 0; i < *count; i++)
+    {
+        duk_get_prop_index(duk, index, i);
+        values[i] = (float)duk_to_number(duk, -1);
+        duk_pop(duk);
+    }
+
+    return values;
+}
+
+static duk_ret_t duk_mesh(duk_context* duk)
+{
+    s32 drawn = 0;
+
+    if(duk_is_array(duk, 0) && duk_is_array(duk, 1) && duk_get_length(duk, 1) >= TIC_MESH_MATRIX)
+    {
+        tic_mem* tic = (tic_mem*)getDukCore(duk);
+        tic_texture_src src = duk_opt_int(duk, 2, tic_tiles_texture);
+        bool cull = duk_opt_boolean(duk, 4, false);
+
+        static u8 colors[TIC_PALETTE_SIZE];
+        s32 count = 0;
+        {
+            if(!duk_is_null_or_undefined(duk, 3))
+            {
+                if(duk_is_array(duk, 3))
+                {
+                    for(s32 i = 0; i < TIC_PALETTE_SIZE; i++)
+                    {
+                        duk_get_prop_index(duk, 3, i);
+                        if(duk_is_null_or_undefined(duk, -1))
+                        {
+                            duk_pop(duk);
+                            break;
+                        }
+                        else
+                        {
+                            colors[i] = duk_to_int(duk, -1);
+                            count++;
+                            duk_pop(duk);
+                        }
+                    }
+                }
+                else
+                {
+                    colors[0] = duk_to_int(duk, 3);
+                    count = 1;
+                }
+            }
+        }
+
+        s32 size;
+        float* matrix = getDukFloats(duk, 1, &size);
+        float* vertices = getDukFloats(duk, 0, &size);
+
+        drawn = tic_api_mesh(tic, vertices, size / TIC_MESH_VERTEX, matrix, src, colors, count, cull);
+
+        free(vertices);
+        free(matrix);
+    }
+
+    duk_push_int(duk, drawn);
+
+    return 1;
+}
+
 
 static duk_ret_t duk_clip(duk_context* duk)
 {
@@ -33,6 +33,9 @@
 
 s32 luaopen_lpeg(lua_State *lua);
 
+// registry field with the code the VM was started or reloaded with
+#define LUA_CODE_KEY "_TIC80_CODE"
+
 static inline s32 getLuaNumber(lua_State* lua, s32 index)
 {
     return (s32)lua_tonumber(lua, index);
@@ -484,6 +487,88 @@ static s32 lua_textri(lua_State* lua)
     return 0;
 }
 
+// returns NULL if the table is too big to copy
+static float* getLuaFloats(lua_State* lua, s32 index, s32* count)
+{
+    *count = (s32)lua_rawlen(lua, index);
+    float* values = malloc(*count * sizeof(float) + 1);
+
+    if(!values)
+        return NULL;
+
+    for(s32 i = 0; i < *count; i++)
+    {
+        lua_rawgeti(lua, index, i + 1);
+        values[i] = (float)lua_tonumber(lua, -1);
+        lua_pop(lua, 1);
+    }
+
+    return values;
+}
+
+static s32 lua_mesh(lua_State* lua)
+{
+    s32 top = lua_gettop(lua);
+
+    if(top >= 2 && lua_istable(lua, 1) && lua_istable(lua, 2) && lua_rawlen(lua, 2) >= TIC_MESH_MATRIX)
+    {
+        tic_mem* tic = (tic_mem*)getLuaCore(lua);
+        static u8 colors[TIC_PALETTE_SIZE];
+        s32 count = 0;
+        tic_texture_src src = top >= 3 ? lua_tointeger(lua, 3) : tic_tiles_texture;
+        bool cull = top >= 5 && lua_toboolean(lua, 5);
+
+        //  check for chroma 
+        if(top >= 4)
+        {
+            if(lua_istable(lua, 4))
+            {
+                for(s32 i = 1; i <= TIC_PALETTE_SIZE; i++)
+                {
+                    lua_rawgeti(lua, 4, i);
+                    if(lua_isnumber(lua, -1))
+                    {
+                        colors[i-1] = getLuaNumber(lua, -1);
+                        count++;
+                        lua_pop(lua, 1);
+                    }
+                    else
+                    {
+                        lua_pop(lua, 1);
+                        break;
+                    }
+                }
+            }
+            else if(lua_isnumber(lua, 4))
+            {
+                colors[0] = getLuaNumber(lua, 4);
+                count = 1;
+            }
+        }
+
+        s32 size;
+        float* matrix = getLuaFloats(lua, 2, &size);
+        float* vertices = getLuaFloats(lua, 1, &size);
+
+        if(!matrix || !vertices)
+        {
+            free(vertices);
+            free(matrix);
+            luaL_error(lua, "not enough memory for the mesh\n");
+            return 0;
+        }
+
+        lua_pushinteger(lua, tic_api_mesh(tic, vertices, size / TIC_MESH_VERTEX, matrix, src, colors, count, cull));
+
+        free(vertices);
+        free(matrix);
+
+        return 1;
+    }
+    else luaL_error(lua, "invalid parameters, mesh(vertices,matrix,[src=0],[chroma=off],[cull=false])\n");
+    return 0;
+}
+
 
 static s32 lua_clip(lua_State* lua)
 {
@@ -1454,6 +1539,9 @@ void closeLua(tic_mem* tic)
     {
         lua_close(core->currentVM);
         core->currentVM = NULL;
+
+        // the next state can get the same address, it still has to get the gc mode
+        core->gc.vm = NULL;
     }
 }
 
@@ -1478,6 +1566,9 @@ static bool initLua(tic_mem* tic, const char* code)
             core->data->error(core->data->data, lua_tostring(lua, -1));
             return false;
         }
+
+        lua_pushstring(lua, code);
+        lua_setfield(lua, LUA_REGISTRYINDEX, LUA_CODE_KEY);
     }
 
     return true;
@@ -1557,6 +1648,54 @@ void callLuaTick(tic_mem* tic)
     }
 }
 
+void collectLuaGarbage(tic_mem* tic, clock_t budget)
+{
+    tic_core* core = (tic_core*)tic;
+    lua_State* lua = core->currentVM;
+
+    if(!lua) return;
+
+    // a new VM runs with the defaults
+    if(core->gc.vm != lua)
+    {
+        core->gc.vm = lua;
+        core->gc.mode = tic_gc_auto;
+    }
+
+    // the mode is only applied when it's changed, so the cart's own collectgarbage() calls stay in effect
+    if(core->gc.mode != tic->gc.mode)
+    {
+        core->gc.mode = tic->gc.mode;
+
+        switch(tic->gc.mode)
+        {
+        case tic_gc_off:
+            lua_gc(lua, LUA_GCSTOP, 0);
+            break;
+        case tic_gc_generational:
+            lua_gc(lua, LUA_GCRESTART, 0);
+#if defined(LUA_GCGEN)
+            lua_gc(lua, LUA_GCGEN, 0, 0);
+#endif
+            break;
+        default:
+            lua_gc(lua, LUA_GCRESTART, 0);
+#if defined(LUA_GCINC)
+            lua_gc(lua, LUA_GCINC, 0, 0, 0);
+#endif
+        }
+    }
+
+    if(tic->gc.mode == tic_gc_step)
+    {
+        // at least one step per frame, then until the cycle is finished or the budget is spent
+        clock_t start = tic_core_clock();
+        while(!lua_gc(lua, LUA_GCSTEP, 0) && tic_core_clock() - start < budget);
+    }
+
+    tic->gc.heap = lua_gc(lua, LUA_GCCOUNT, 0) * 1024 + lua_gc(lua, LUA_GCCOUNTB, 0);
+}
+
 void callLuaIntCallback(tic_mem* tic, s32 value, void* data, const char* name)
 {
     tic_core* core = (tic_core*)tic;
@@ -1677,6 +1816,416 @@ static void evalLua(tic_mem* tic, const char* code) {
     }
 }
 
+// hot reload: top level global functions are reloaded into the running VM,
+// it's only possible if the rest of the code hasn't changed
+
+typedef enum
+{
+    LuaTokenName,
+    LuaTokenString,
+    LuaTokenSymbol,
+} LuaTokenType;
+
+typedef struct
+{
+    LuaTokenType type;
+    const char* pos;
+    s32 size;
+} LuaToken;
+
+typedef struct
+{
+    const char* start;
+    const char* end;
+    LuaToken name;
+} LuaFuncDef;
+
+typedef struct
+{
+    LuaFuncDef* funcs;
+    s32 funcsCount;
+
+    LuaToken* locals;
+    s32 localsCount;
+} LuaDefs;
+
+static inline bool isLuaToken(const LuaToken* token, const char* str)
+{
+    return token->type == LuaTokenName
+        && token->size == strlen(str)
+        && memcmp(token->pos, str, token->size) == 0;
+}
+
+static inline bool isLuaSymbol(const LuaToken* token, char c)
+{
+    return token->type == LuaTokenSymbol && *token->pos == c;
+}
+
+static inline bool equalLuaTokens(const LuaToken* a, const LuaToken* b)
+{
+    return a->size == b->size && memcmp(a->pos, b->pos, a->size) == 0;
+}
+
+// returns the end of [[...]] or [==[...]==], NULL if it isn't a long bracket
+static const char* skipLuaLongBracket(const char* ptr)
+{
+    s32 level = 0;
+
+    for(ptr++; *ptr == '='; ptr++)
+        level++;
+
+    if(*ptr != '[')
+        return NULL;
+
+    for(ptr++; *ptr; ptr++)
+        if(*ptr == ']')
+        {
+            const char* end = ptr + 1;
+            s32 closing = 0;
+
+            for(; *end == '='; end++)
+                closing++;
+
+            if(*end == ']' && closing == level)
+                return end + 1;
+        }
+
+    return ptr;
+}
+
+static bool nextLuaToken(const char** code, LuaToken* token)
+{
+    const char* ptr = *code;
+
+    while(*ptr)
+    {
+        if(isspace((u8)*ptr))
+            ptr++;
+        else if(ptr[0] == '-' && ptr[1] == '-')
+        {
+            const char* end = ptr[2] == '[' ? skipLuaLongBracket(ptr + 2) : NULL;
+
+            if(end) ptr = end;
+            else while(*ptr && *ptr != '\n') ptr++;
+        }
+        else break;
+    }
+
+    if(!*ptr)
+        return false;
+
+    const char* start = ptr;
+
+    if(isalnum_(*ptr))
+    {
+        token->type = LuaTokenName;
+
+        while(isalnum_(*ptr)) ptr++;
+    }
+    else if(*ptr == '"' || *ptr == '\'')
+    {
+        token->type = LuaTokenString;
+
+        char quote = *ptr++;
+
+        while(*ptr && *ptr != quote)
+            if(*ptr++ == '\\' && *ptr)
+                ptr++;
+
+        if(*ptr) ptr++;
+    }
+    else if(*ptr == '[' && (ptr = skipLuaLongBracket(start)))
+    {
+        token->type = LuaTokenString;
+    }
+    else
+    {
+        token->type = LuaTokenSymbol;
+        ptr = start + 1;
+    }
+
+    token->pos = start;
+    token->size = (s32)(ptr - start);
+    *code = ptr;
+
+    return true;
+}
+
+static void addLuaLocal(LuaDefs* defs, const LuaToken* name)
+{
+    defs->locals = realloc(defs->locals, (defs->localsCount + 1) * sizeof(LuaToken));
+    defs->locals[defs->localsCount++] = *name;
+}
+
+static void freeLuaDefs(LuaDefs* defs)
+{
+    free(defs->funcs);
+    free(defs->locals);
+}
+
+// finds global functions defined at the top level and top level locals
+static void parseLuaDefs(const char* code, LuaDefs* defs)
+{
+    *defs = (LuaDefs){0};
+
+    s32 depth = 0;
+    LuaToken token, name;
+    LuaFuncDef* func = NULL;
+    const char* ptr = code;
+
+    while(nextLuaToken(&ptr, &token))
+    {
+        if(token.type != LuaTokenName)
+            continue;
+
+        if(depth == 0 && isLuaToken(&token, "local"))
+        {
+            const char* next = ptr;
+
+            if(!nextLuaToken(&next, &name))
+                break;
+
+            if(isLuaToken(&name, "function"))
+            {
+                depth++;
+                ptr = next;
+
+                if(nextLuaToken(&next, &name) && name.type == LuaTokenName)
+                {
+                    addLuaLocal(defs, &name);
+                    ptr = next;
+                }
+
+                continue;
+            }
+
+            while(name.type == LuaTokenName)
+            {
+                addLuaLocal(defs, &name);
+                ptr = next;
+
+                if(!nextLuaToken(&next, &name))
+                    break;
+
+                // skip <const> and <close> attributes
+                if(isLuaSymbol(&name, '<'))
+                {
+                    nextLuaToken(&next, &name);
+                    nextLuaToken(&next, &name);
+                    ptr = next;
+
+                    if(!nextLuaToken(&next, &name))
+                        break;
+                }
+
+                if(!isLuaSymbol(&name, ',') || !nextLuaToken(&next, &name))
+                    break;
+            }
+        }
+        else if(isLuaToken(&token, "function"))
+        {
+            if(depth == 0)
+            {
+                // function name is 'a', 'a.b.c' or 'a.b:c'
+                const char* next = ptr;
+                LuaToken path = {LuaTokenName, NULL, 0};
+
+                while(nextLuaToken(&next, &name) && name.type == LuaTokenName)
+                {
+                    if(!path.pos) path.pos = name.pos;
+                    path.size = (s32)(name.pos + name.size - path.pos);
+                    ptr = next;
+
+                    if(!nextLuaToken(&next, &name) || !(isLuaSymbol(&name, '.') || isLuaSymbol(&name, ':')))
+                        break;
+                }
+
+                if(path.pos)
+                {
+                    defs->funcs = realloc(defs->funcs, (defs->funcsCount + 1) * sizeof(LuaFuncDef));
+                    func = &defs->funcs[defs->funcsCount++];
+                    *func = (LuaFuncDef){token.pos, NULL, path};
+                }
+            }
+
+            depth++;
+        }
+        else if(isLuaToken(&token, "if") || isLuaToken(&token, "do") || isLuaToken(&token, "repeat"))
+            depth++;
+        else if(isLuaToken(&token, "end") || isLuaToken(&token, "until"))
+        {
+            if(depth > 0 && --depth == 0 && func)
+            {
+                func->end = token.pos + token.size;
+                func = NULL;
+            }
+        }
+    }
+}
+
+// next token outside of the top level functions
+static bool nextLuaRestToken(const char** code, const LuaDefs* defs, s32* index, LuaToken* token)
+{
+    while(nextLuaToken(code, token))
+    {
+        while(*index < defs->funcsCount && defs->funcs[*index].end && token->pos >= defs->funcs[*index].end)
+            (*index)++;
+
+        const LuaFuncDef* func = *index < defs->funcsCount ? &defs->funcs[*index] : NULL;
+
+        if(func && func->end && token->pos >= func->start)
+            *code = func->end;
+        else return true;
+    }
+
+    return false;
+}
+
+static bool equalLuaRest(const char* code1, const LuaDefs* defs1, const char* code2, const LuaDefs* defs2)
+{
+    LuaToken token1, token2;
+    s32 index1 = 0, index2 = 0;
+
+    while(true)
+    {
+        bool next1 = nextLuaRestToken(&code1, defs1, &index1, &token1);
+        bool next2 = nextLuaRestToken(&code2, defs2, &index2, &token2);
+
+        if(!next1 || !next2)
+            return next1 == next2;
+
+        if(!equalLuaTokens(&token1, &token2))
+            return false;
+    }
+}
+
+static bool equalLuaFuncs(const LuaFuncDef* a, const LuaFuncDef* b)
+{
+    return a->end && b->end
+        && a->end - a->start == b->end - b->start
+        && memcmp(a->start, b->start, a->end - a->start) == 0;
+}
+
+static const LuaFuncDef* findLuaFunc(const LuaDefs* defs, const LuaToken* name)
+{
+    for(s32 i = 0; i < defs->funcsCount; i++)
+        if(equalLuaTokens(&defs->funcs[i].name, name))
+            return &defs->funcs[i];
+
+    return NULL;
+}
+
+// top level locals are upvalues of the main chunk, reloaded function can't see them
+static bool usesLuaLocals(const LuaFuncDef* func, const LuaDefs* defs)
+{
+    LuaToken token;
+    const char* ptr = func->start;
+
+    while(nextLuaToken(&ptr, &token) && token.pos < func->end)
+        if(token.type == LuaTokenName)
+            for(s32 i = 0; i < defs->localsCount; i++)
+                if(equalLuaTokens(&token, &defs->locals[i]))
+                    return true;
+
+    return false;
+}
+
+static bool reloadLuaFunc(tic_core* core, const char* code, const LuaFuncDef* func)
+{
+    lua_State* lua = core->currentVM;
+
+    // pad the chunk with empty lines to keep line numbers in error messages
+    s32 lines = 0;
+    for(const char* ptr = code; ptr < func->start; ptr++)
+        if(*ptr == '\n')
+            lines++;
+
+    s32 size = (s32)(func->end - func->start);
+    char* chunk = malloc(lines + size);
+
+    memset(chunk, '\n', lines);
+    memcpy(chunk + lines, func->start, size);
+
+    // the first line is enough for the chunk name, the rest is cut anyway
+    const char* nl = strchr(code, '\n');
+    lua_pushlstring(lua, code, nl ? nl - code + 1 : strlen(code));
+    const char* name = lua_tostring(lua, -1);
+
+    bool done = luaL_loadbuffer(lua, chunk, lines + size, name) == LUA_OK 
+        && docall(lua, 0, 0) == LUA_OK;
+
+    if(!done)
+        core->data->error(core->data->data, lua_tostring(lua, -1));
+
+    free(chunk);
+    lua_settop(lua, 0);
+
+    return done;
+}
+
+static bool reloadLua(tic_mem* tic, const char* code)
+{
+    tic_core* core = (tic_core*)tic;
+    lua_State* lua = core->currentVM;
+
+    if (!lua) return false;
+
+    lua_settop(lua, 0);
+    lua_getfield(lua, LUA_REGISTRYINDEX, LUA_CODE_KEY);
+    const char* prev = lua_tostring(lua, -1);
+
+    if(!prev || strcmp(prev, code) == 0)
+    {
+        lua_settop(lua, 0);
+        return prev != NULL;
+    }
+
+    // check syntax of the whole code first
+    if(luaL_loadstring(lua, code) != LUA_OK)
+    {
+        core->data->error(core->data->data, lua_tostring(lua, -1));
+        lua_settop(lua, 0);
+        return false;
+    }
+
+    LuaDefs prevDefs, defs;
+    parseLuaDefs(prev, &prevDefs);
+    parseLuaDefs(code, &defs);
+
+    bool done = equalLuaRest(prev, &prevDefs, code, &defs);
+
+    for(s32 i = 0; i < defs.funcsCount && done; i++)
+    {
+        const LuaFuncDef* func = &defs.funcs[i];
+        const LuaFuncDef* prevFunc = findLuaFunc(&prevDefs, &func->name);
+
+        if(!(prevFunc && equalLuaFuncs(prevFunc, func)))
+            done = func->end && !usesLuaLocals(func, &defs);
+    }
+
+    for(s32 i = 0; i < defs.funcsCount && done; i++)
+    {
+        const LuaFuncDef* func = &defs.funcs[i];
+        const LuaFuncDef* prevFunc = findLuaFunc(&prevDefs, &func->name);
+
+        if(!(prevFunc && equalLuaFuncs(prevFunc, func)))
+            done = reloadLuaFunc(core, code, func);
+    }
+
+    freeLuaDefs(&prevDefs);
+    freeLuaDefs(&defs);
+
+    if(done)
+    {
+        lua_pushstring(lua, code);
+        lua_setfield(lua, LUA_REGISTRYINDEX, LUA_CODE_KEY);
+    }
+
+    lua_settop(lua, 0);
+
+    return done;
+}
+
 tic_script_config LuaSyntaxConfig = 
 {
     .name               = "lua",
@@ -1685,6 +2234,7 @@ tic_script_config LuaSyntaxConfig =
     .init               = initLua,
     .close              = closeLua,
     .tick               = callLuaTick,
+    .gc                 = collectLuaGarbage,
 
     .callback           =
     {
@@ -1695,6 +2245,7 @@ tic_script_config LuaSyntaxConfig =
 
     .getOutline         = getLuaOutline,
     .eval               = evalLua,
+    .reload             = reloadLua,
 
     .blockCommentStart  = "--[[",
     .blockCommentEnd    = "]]",
@@ -33,6 +33,7 @@ s32 luaopen_lpeg(lua_State *lua);
 
 extern void initLuaAPI(tic_core* core);
 extern void callLuaTick(tic_mem* tic);
+extern void collectLuaGarbage(tic_mem* tic, clock_t budget);
 extern void callLuaScanlineName(tic_mem* tic, s32 row, void* data, const char* name);
 extern void callLuaScanline(tic_mem* tic, s32 row, void* data);
 extern void callLuaBorder(tic_mem* tic, s32 row, void* data);
@@ -198,6 +198,7 @@ tic_script_config MoonSyntaxConfig =
     .init               = initMoonscript,
     .close              = closeLua,
     .tick               = callLuaTick,
+    .gc                 = collectLuaGarbage,
     .callback           =
     {
         .scanline       = callLuaScanline,
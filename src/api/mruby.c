@@ -339,6 +339,68 @@ static mrb_value mrb_textri(mrb_state* mrb, mrb_value self)
     return mrb_nil_value();
 }
 
+static float* getMRubyFloats(mrb_state* mrb, mrb_value array, s32* count)
+{
+    *count = ARY_LEN(RARRAY(array));
+    float* values = malloc(*count * sizeof(float) + 1);
+
+    for (s32 i = 0; i < *count; ++i)
+    {
+        values[i] = mrb_to_flo(mrb, mrb_ary_entry(array, i));
+    }
+
+    return values;
+}
+
+static mrb_value mrb_mesh(mrb_state* mrb, mrb_value self)
+{
+    mrb_value vertices, matrix;
+    mrb_value chroma = mrb_fixnum_value(0xff);
+    mrb_int src = tic_tiles_texture;
+    mrb_bool cull = false;
+
+    mrb_get_args(mrb, "AA|iob", &vertices, &matrix, &src, &chroma, &cull);
+
+    if (ARY_LEN(RARRAY(matrix)) < TIC_MESH_MATRIX)
+    {
+        mrb_raise(mrb, E_ARGUMENT_ERROR, "invalid parameters, mesh(vertices,matrix,[src=0],[chroma=off],[cull=false])");
+        return mrb_nil_value();
+    }
+
+    mrb_int count;
+    u8 *chromas;
+    if (mrb_array_p(chroma))
+    {
+        count = ARY_LEN(RARRAY(chroma));
+        chromas = malloc(count * sizeof(u8));
+
+        for (mrb_int i = 0; i < count; ++i)
+        {
+            chromas[i] = mrb_integer(mrb_ary_entry(chroma, i));
+        }
+    }
+    else
+    {
+        count = 1;
+        chromas = malloc(sizeof(u8));
+        chromas[0] = mrb_integer(chroma);
+    }
+
+    s32 matrixSize, verticesSize;
+    float* matrixData = getMRubyFloats(mrb, matrix, &matrixSize);
+    float* verticesData = getMRubyFloats(mrb, vertices, &verticesSize);
+
+    tic_mem* memory = (tic_mem*)getMRubyMachine(mrb);
+
+    s32 drawn = tic_api_mesh(memory, verticesData, verticesSize / TIC_MESH_VERTEX, matrixData, src, chromas, count, cull);
+
+    free(verticesData);
+    free(matrixData);
+    free(chromas);
+
+    return mrb_fixnum_value(drawn);
+}
+
 
 static mrb_value mrb_clip(mrb_state* mrb, mrb_value self)
 {
@@ -529,6 +529,87 @@ static SQInteger squirrel_textri(HSQUIRRELVM vm)
     return 0;
 }
 
+static float* getSquirrelFloats(HSQUIRRELVM vm, s32 index, s32* count)
+{
+    *count = (s32)sq_getsize(vm, index);
+    float* values = malloc(*count * sizeof(float) + 1);
+
+    for(s32 i = 0; i < *count; i++)
+    {
+        sq_pushinteger(vm, (SQInteger)i);
+        sq_rawget(vm, index);
+        values[i] = getSquirrelFloat(vm, -1);
+        sq_poptop(vm);
+    }
+
+    return values;
+}
+
+static SQInteger squirrel_mesh(HSQUIRRELVM vm)
+{
+    SQInteger top = sq_gettop(vm);
+
+    if (top >= 3 && OT_ARRAY == sq_gettype(vm, 2) && OT_ARRAY == sq_gettype(vm, 3) 
+        && sq_getsize(vm, 3) >= TIC_MESH_MATRIX)
+    {
+        tic_mem* tic = (tic_mem*)getSquirrelCore(vm);
+        static u8 colors[TIC_PALETTE_SIZE];
+        s32 count = 0;
+        tic_texture_src src = tic_tiles_texture;
+        bool cull = false;
+
+        //  check for texture source
+        if (top >= 4)
+        {
+            src = getSquirrelNumber(vm, 4);
+        }
+        //  check for chroma 
+        if(OT_ARRAY == sq_gettype(vm, 5))
+        {
+            for(s32 i = 0; i < TIC_PALETTE_SIZE; i++)
+            {
+                sq_pushinteger(vm, (SQInteger)i);
+                sq_rawget(vm, 5);
+                if(sq_gettype(vm, -1) & (OT_FLOAT|OT_INTEGER))
+                {
+                    colors[i] = getSquirrelNumber(vm, -1);
+                    count++;
+                    sq_poptop(vm);
+                }
+                else
+                {
+                    sq_poptop(vm);
+                    break;
+                }
+            }
+        }
+        else if (top >= 5)
+        {
+            colors[0] = getSquirrelNumber(vm, 5);
+            count = 1;
+        }
+
+        if (top >= 6)
+        {
+            SQBool b = SQFalse;
+            sq_getbool(vm, 6, &b);
+            cull = (b != SQFalse);
+        }
+
+        s32 size;
+        float* matrix = getSquirrelFloats(vm, 3, &size);
+        float* vertices = getSquirrelFloats(vm, 2, &size);
+
+        sq_pushinteger(vm, tic_api_mesh(tic, vertices, size / TIC_MESH_VERTEX, matrix, src, colors, count, cull));
+
+        free(vertices);
+        free(matrix);
+
+        return 1;
+    }
+    else return sq_throwerror(vm, "invalid parameters, mesh(vertices,matrix,[texsrc=0],[chroma=off],[cull=false])\n");
+}
+
 
 static SQInteger squirrel_clip(HSQUIRRELVM vm)
 {
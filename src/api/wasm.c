@@ -293,6 +293,38 @@ m3ApiRawFunction(wasmtic_textri)
 }
 
 
+m3ApiRawFunction(wasmtic_mesh)
+{
+    m3ApiReturnType  (int32_t)
+
+    m3ApiGetArgMem   (const float*, vertices)
+    m3ApiGetArg      (int32_t, count)
+    m3ApiGetArgMem   (const float*, matrix)
+    m3ApiGetArg      (int32_t, texsrc)
+    m3ApiGetArgMem   (u8*, trans_colors)
+    m3ApiGetArg      (int8_t, colorCount)
+    m3ApiGetArg      (int32_t, cull)
+
+    if (trans_colors == NULL) {
+        colorCount = 0;
+    }
+
+    count = MAX(count, 0);
+
+    // vertices and matrix are used in place, so they must fit into the linear memory,
+    // the size is 64-bit to not let a huge count wrap around the check
+    m3ApiCheckMem(vertices, (u64)count * TIC_MESH_VERTEX * sizeof(float));
+    m3ApiCheckMem(matrix, TIC_MESH_MATRIX * sizeof(float));
+    m3ApiCheckMem(trans_colors, colorCount);
+
+    tic_mem* tic = (tic_mem*)getWasmCore(runtime);
+
+    m3ApiReturn(tic_api_mesh(tic, vertices, count, matrix, texsrc, trans_colors, colorCount, cull != 0));
+
+    m3ApiSuccess();
+}
+
+
 m3ApiRawFunction(wasmtic_trib)
 {
     m3ApiGetArg      (float, x1)
@@ -989,6 +1021,7 @@ M3Result linkTicAPI(IM3Module module)
     _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "tri",     "v(iiiiiii)",    &wasmtic_tri)));
     _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "trib",    "v(iiiiiii)",    &wasmtic_trib)));
     _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "textri",  "v(iiiiiiiiiiiiiii)",    &wasmtic_textri)));
+    _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "mesh",    "i(*i*i*ii)",    &wasmtic_mesh)));
     _   (SuppressLookupFailure (m3_LinkRawFunction (module, "env", "vbank",   "i(i)",          &wasmtic_vbank)));
 
 _catch:
@@ -1017,27 +1050,55 @@ static void closeWasm(tic_mem* tic)
 
     if(core->currentVM)
     {
-        // this is necessary because when TIC-80 calls tic_reset_api, we
-        // may not even have a VM.  Because the [non WASM] VM isn't
-        // initialized yet when loading a new cartridge the "init" steps
-        // are being applied to the WASM RAM, not the base RAM, so as we're
-        // on our way out we need to copy the our lower 96kb back into base
-        // RAM to close this loophole
-
-        // TODO: This could also be fixed by correcting the sequencing such
-        // that prior VMs were released before starting the init process
-        // for an entirely different VM.  This sequencing matters a lot
-        // less if one assumes (like before) that all the VMs share a
-        // common memory area.
-        u8* low_ram =  (u8*)core->memory.base_ram;
-        u8* wasm_ram = m3_GetMemory(core->currentVM, NULL, 0);
-        memcpy(low_ram, wasm_ram, TIC_RAM_SIZE);
-        deinitWasmRuntime(core->currentVM);
+        IM3Runtime runtime = core->currentVM;
+
+        // RAM lives in the linear memory, detach it from the runtime and
+        // keep it for the next run instead of copying RAM back
+        if(runtime->memory.mallocated && runtime->memory.numPages == TIC_WASM_PAGE_COUNT)
+        {
+            core->vmram = runtime->memory.mallocated;
+            runtime->memory.mallocated = NULL;
+            runtime->memory.numPages = 0;
+        }
+        else
+        {
+            // the module resized its memory, fall back to the base RAM
+            if(runtime->memory.mallocated)
+                memcpy(core->memory.base_ram, core->memory.ram, TIC_RAM_SIZE);
+
+            core->memory.ram = core->memory.base_ram;
+        }
+
+        deinitWasmRuntime(runtime);
         core->currentVM = NULL;
-        core->memory.ram = NULL;
     }
 }
 
+static void mapWasmRam(tic_core* core, IM3Runtime runtime)
+{
+    if(core->vmram)
+    {
+        // RAM already lives in the memory block left by the previous run
+        runtime->memory.mallocated = core->vmram;
+        runtime->memory.numPages = TIC_WASM_PAGE_COUNT;
+        core->vmram = NULL;
+        ResizeMemory(runtime, TIC_WASM_PAGE_COUNT);
+
+        // only RAM carries over, the rest of the linear memory starts zeroed as usual
+        u32 size = 0;
+        u8* memory = m3_GetMemory(runtime, &size, 0);
+        memset(memory + TIC_RAM_SIZE, 0, size - TIC_RAM_SIZE);
+    }
+    else
+    {
+        // first run, move RAM into the linear memory
+        ResizeMemory(runtime, TIC_WASM_PAGE_COUNT);
+        memcpy(m3_GetMemory(runtime, NULL, 0), core->memory.ram, TIC_RAM_SIZE);
+    }
+
+    core->memory.ram = (tic_ram*)m3_GetMemory(runtime, NULL, 0);
+}
+
 // TODO: restore functionality
 // static u64 ForceExitCounter = 0;
 
@@ -1070,12 +1131,7 @@ static bool initWasm(tic_mem* tic, const char* code)
     }
 
     runtime->memory.maxPages = TIC_WASM_PAGE_COUNT;
-    ResizeMemory(runtime, TIC_WASM_PAGE_COUNT);
-
-    u8* low_ram =  (u8*)core->memory.ram;
-    u8* wasm_ram = m3_GetMemory(runtime, NULL, 0);
-    memcpy(wasm_ram, low_ram, TIC_RAM_SIZE);
-    core->memory.ram = (tic_ram*)wasm_ram;
+    mapWasmRam(core, runtime);
 
     core->currentVM = runtime;
 
@@ -1103,19 +1159,25 @@ static bool initWasm(tic_mem* tic, const char* code)
 
     if (result){
         core->data->error(core->data->data, result);
+        closeWasm(tic);
         return false;
     }
 
     result = m3_LoadModule (runtime, module);
     if (result){
         core->data->error(core->data->data, result);
+        closeWasm(tic);
         return false;
     }
 
+    // memory section of the module could resize the linear memory
+    core->memory.ram = (tic_ram*)m3_GetMemory(runtime, NULL, 0);
+
     result = linkTicAPI(runtime->modules);
     if (result)
     {
         core->data->error(core->data->data, result);
+        closeWasm(tic);
         return false;
     }
 
@@ -1126,6 +1188,7 @@ static bool initWasm(tic_mem* tic, const char* code)
     if (result)
     {
         core->data->error(core->data->data, "Error: WASM must export a TIC function.");
+        closeWasm(tic);
         return false;
     }
 
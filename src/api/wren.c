@@ -76,6 +76,10 @@ class TIC {\n\
     foreign static textri(x1, y1, x2, y2, x3, y3, u1, v1, u2, v2, u3, v3)\n\
     foreign static textri(x1, y1, x2, y2, x3, y3, u1, v1, u2, v2, u3, v3, src)\n\
     foreign static textri(x1, y1, x2, y2, x3, y3, u1, v1, u2, v2, u3, v3, src, alpha_color)\n\
+    foreign static mesh(vertices, matrix)\n\
+    foreign static mesh(vertices, matrix, src)\n\
+    foreign static mesh(vertices, matrix, src, alpha_color)\n\
+    foreign static mesh(vertices, matrix, src, alpha_color, cull)\n\
     foreign static pix(x, y)\n\
     foreign static pix(x, y, color)\n\
     foreign static line(x0, y0, x1, y1, color)\n\
@@ -784,6 +788,86 @@ static void wren_textri(WrenVM* vm)
                         colors, count); // chroma
 }
 
+static float* getWrenFloats(WrenVM* vm, s32 index, s32 slot, s32* count)
+{
+    *count = wrenGetListCount(vm, index);
+    float* values = malloc(*count * sizeof(float) + 1);
+
+    for(s32 i = 0; i < *count; i++)
+    {
+        wrenGetListElement(vm, index, i, slot);
+        values[i] = (float)wrenGetSlotDouble(vm, slot);
+    }
+
+    return values;
+}
+
+static void wren_mesh(WrenVM* vm)
+{
+    int top = wrenGetSlotCount(vm);
+
+    if(!isList(vm, 1) || !isList(vm, 2) || wrenGetListCount(vm, 2) < TIC_MESH_MATRIX)
+    {
+        wrenError(vm, "invalid parameters, mesh(vertices,matrix,[src=0],[chroma=off],[cull=false])\n");
+        return;
+    }
+
+    tic_mem* tic = (tic_mem*)getWrenCore(vm);
+    static u8 colors[TIC_PALETTE_SIZE];
+    s32 count = 0;
+    tic_texture_src src = tic_tiles_texture;
+    bool cull = false;
+
+    wrenEnsureSlots(vm, top+1);
+
+    //  check for texture source
+    if (top > 3)
+    {
+        src = getWrenNumber(vm, 3);
+    }
+
+    //  check for chroma 
+    if(top > 4)
+    {
+        if(isList(vm, 4))
+        {
+            int list_count = wrenGetListCount(vm, 4);
+            for(s32 i = 0; i < TIC_PALETTE_SIZE && i < list_count; i++)
+            {
+                wrenGetListElement(vm, 4, i, top);
+                if(isNumber(vm, top))
+                {
+                    colors[i] = getWrenNumber(vm, top);
+                    count++;
+                }
+                else
+                {
+                    break;
+                }
+            }
+        }
+        else 
+        {
+            colors[0] = getWrenNumber(vm, 4);
+            count = 1;
+        }
+    }
+
+    if (top > 5)
+    {
+        cull = wrenGetSlotBool(vm, 5);
+    }
+
+    s32 size;
+    float* matrix = getWrenFloats(vm, 2, top, &size);
+    float* vertices = getWrenFloats(vm, 1, top, &size);
+
+    wrenSetSlotDouble(vm, 0, tic_api_mesh(tic, vertices, size / TIC_MESH_VERTEX, matrix, src, colors, count, cull));
+
+    free(vertices);
+    free(matrix);
+}
+
 static void wren_pix(WrenVM* vm)
 {
     int top = wrenGetSlotCount(vm);
@@ -1370,6 +1454,10 @@ static WrenForeignMethodFn foreignTicMethods(const char* signature)
     if (strcmp(signature, "static TIC.textri(_,_,_,_,_,_,_,_,_,_,_,_)"       ) == 0) return wren_textri;
     if (strcmp(signature, "static TIC.textri(_,_,_,_,_,_,_,_,_,_,_,_,_)"     ) == 0) return wren_textri;
     if (strcmp(signature, "static TIC.textri(_,_,_,_,_,_,_,_,_,_,_,_,_,_)"   ) == 0) return wren_textri;
+    if (strcmp(signature, "static TIC.mesh(_,_)"                             ) == 0) return wren_mesh;
+    if (strcmp(signature, "static TIC.mesh(_,_,_)"                           ) == 0) return wren_mesh;
+    if (strcmp(signature, "static TIC.mesh(_,_,_,_)"                         ) == 0) return wren_mesh;
+    if (strcmp(signature, "static TIC.mesh(_,_,_,_,_)"                       ) == 0) return wren_mesh;
 
     if (strcmp(signature, "static TIC.pix(_,_)"                 ) == 0) return wren_pix;
     if (strcmp(signature, "static TIC.pix(_,_,_)"               ) == 0) return wren_pix;
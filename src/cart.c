@@ -21,9 +21,9 @@
 // SOFTWARE.
 
 #include "cart.h"
+#include "tools.h"
 
 #if defined(DEPRECATED_CHUNKS)
-#include "tools.h"
 #include "ext/gif.h"
 #endif
 
@@ -57,6 +57,9 @@ typedef enum
     CHUNK_DEFAULT,      // 17
     CHUNK_SCREEN,       // 18
     CHUNK_BINARY,       // 19
+    CHUNK_COMPRESSED,   // 20 - deflated chunk, temp holds its type, saved on request only
+
+    CHUNK_COUNT,
 } ChunkType;
 
 typedef struct
@@ -67,156 +70,247 @@ typedef struct
     u32 temp:8;
 } Chunk;
 
-static_assert(sizeof(Chunk) == 4, "tic_chunk_size");
+static_assert(sizeof(Chunk) == TIC_CHUNK_HEADER_SIZE, "tic_chunk_size");
 
 static const u8 Sweetie16[] = {0x1a, 0x1c, 0x2c, 0x5d, 0x27, 0x5d, 0xb1, 0x3e, 0x53, 0xef, 0x7d, 0x57, 0xff, 0xcd, 0x75, 0xa7, 0xf0, 0x70, 0x38, 0xb7, 0x64, 0x25, 0x71, 0x79, 0x29, 0x36, 0x6f, 0x3b, 0x5d, 0xc9, 0x41, 0xa6, 0xf6, 0x73, 0xef, 0xf7, 0xf4, 0xf4, 0xf4, 0x94, 0xb0, 0xc2, 0x56, 0x6c, 0x86, 0x33, 0x3c, 0x57};
 static const u8 Waveforms[] = {0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x10, 0x32, 0x54, 0x76, 0x98, 0xba, 0xdc, 0xfe, 0xef, 0xcd, 0xab, 0x89, 0x67, 0x45, 0x23, 0x01, 0x10, 0x32, 0x54, 0x76, 0x98, 0xba, 0xdc, 0xfe, 0x10, 0x32, 0x54, 0x76, 0x98, 0xba, 0xdc, 0xfe};
 
 static s32 chunkSize(const Chunk* chunk)
 {
-    return chunk->size == 0 && chunk->type == CHUNK_CODE ? TIC_BANK_SIZE : chunk->size;
+    // full 64K code and binary banks wrap the size field to zero
+    return chunk->size == 0 && (chunk->type == CHUNK_CODE || chunk->type == CHUNK_BINARY) ? TIC_BANK_SIZE : chunk->size;
 }
 
-void tic_cart_load(tic_cartridge* cart, const u8* buffer, s32 size)
+typedef struct
 {
-    memset(cart, 0, sizeof(tic_cartridge));
-    const u8* end = buffer + size;
+    const u8* data;
+    s32 size;
+    bool compressed;
+} ChunkRef;
 
-#define LOAD_CHUNK(to) memcpy(&to, ptr, MIN(sizeof(to), chunk->size ? chunk->size : TIC_BANK_SIZE))
+typedef ChunkRef ChunkIndex[CHUNK_COUNT][TIC_BANKS];
 
-    // load palette chunk first
+static void indexChunks(ChunkIndex index, const u8* buffer, s32 size)
+{
+    const u8* ptr = buffer;
+    const u8* end = buffer + size;
+
+    while(end - ptr >= (s32)sizeof(Chunk))
     {
-        const u8* ptr = buffer;
-        while (ptr < end)
+        Chunk chunk;
+        memcpy(&chunk, ptr, sizeof chunk);
+        ptr += sizeof(Chunk);
+
+        // truncated chunk is loaded partially and ends the cart
+        s32 size = MIN(chunkSize(&chunk), (s32)(end - ptr));
+
+        if(chunk.type == CHUNK_COMPRESSED)
         {
-            const Chunk* chunk = (Chunk*)ptr;
-            ptr += sizeof(Chunk);
-
-            switch (chunk->type)
-            {
-            case CHUNK_PALETTE:
-                LOAD_CHUNK(cart->banks[chunk->bank].palette);
-                break;
-            case CHUNK_DEFAULT:
-                memcpy(&cart->banks[chunk->bank].palette, Sweetie16, sizeof Sweetie16);
-                memcpy(&cart->banks[chunk->bank].sfx.waveforms, Waveforms, sizeof Waveforms);
-                break;
-            default: break;
-            }
-
-            ptr += chunkSize(chunk);
+            if(chunk.temp < CHUNK_COUNT)
+                index[chunk.temp][chunk.bank] = (ChunkRef){ptr, size, true};
         }
+        else if(chunk.type < CHUNK_COUNT)
+            index[chunk.type][chunk.bank] = (ChunkRef){ptr, size};
+
+        ptr += size;
+    }
+}
+
+// unpacks chunk data straight into the destination, returns unpacked size
+static s32 readChunk(void* dst, s32 size, const ChunkRef* ref)
+{
+    if(!ref->data || size <= 0)
+        return 0;
+
+    if(ref->compressed)
+        return tic_tool_unzip(dst, size, ref->data, ref->size);
+
+    s32 copied = MIN(size, ref->size);
+    memcpy(dst, ref->data, copied);
+
+    return copied;
+}
+
+// loads chunk data and clears the rest of the section
+static void loadSection(void* dst, s32 size, const ChunkRef* ref)
+{
+    s32 copied = readChunk(dst, size, ref);
+
+    memset((u8*)dst + copied, 0, size - copied);
+}
+
+static void loadPalette(tic_palettes* palette, ChunkIndex index, s32 bank)
+{
+    const ChunkRef* ref = &index[CHUNK_PALETTE][bank];
+
+    if(ref->data || !index[CHUNK_DEFAULT][bank].data)
+        loadSection(palette, sizeof *palette, ref);
+    else loadSection(palette, sizeof *palette, &(ChunkRef){Sweetie16, sizeof Sweetie16});
+}
 
 #if defined(DEPRECATED_CHUNKS)
-        // workaround to support ancient carts without palette
-        // load DB16 palette if it not exists
-        if (EMPTY(cart->bank0.palette.vbank0.data))
+static void loadDeprecatedCover(tic_screen* screen, tic_palette* palette, ChunkIndex index)
+{
+    // workaround to support ancient carts without palette
+    // load DB16 palette if it not exists
+    if (EMPTY(palette->data))
+    {
+        static const u8 DB16[] = { 0x14, 0x0c, 0x1c, 0x44, 0x24, 0x34, 0x30, 0x34, 0x6d, 0x4e, 0x4a, 0x4e, 0x85, 0x4c, 0x30, 0x34, 0x65, 0x24, 0xd0, 0x46, 0x48, 0x75, 0x71, 0x61, 0x59, 0x7d, 0xce, 0xd2, 0x7d, 0x2c, 0x85, 0x95, 0xa1, 0x6d, 0xaa, 0x2c, 0xd2, 0xaa, 0x99, 0x6d, 0xc2, 0xca, 0xda, 0xd4, 0x5e, 0xde, 0xee, 0xd6 };
+        memcpy(palette->data, DB16, sizeof DB16);
+    }
+
+    {
+        // workaround to load deprecated cover section
+        const ChunkRef* cover = &index[CHUNK_COVER_DEP][0];
+        gif_image* image = cover->data ? gif_read_data(cover->data, cover->size) : NULL;
+
+        if (image)
         {
-            static const u8 DB16[] = { 0x14, 0x0c, 0x1c, 0x44, 0x24, 0x34, 0x30, 0x34, 0x6d, 0x4e, 0x4a, 0x4e, 0x85, 0x4c, 0x30, 0x34, 0x65, 0x24, 0xd0, 0x46, 0x48, 0x75, 0x71, 0x61, 0x59, 0x7d, 0xce, 0xd2, 0x7d, 0x2c, 0x85, 0x95, 0xa1, 0x6d, 0xaa, 0x2c, 0xd2, 0xaa, 0x99, 0x6d, 0xc2, 0xca, 0xda, 0xd4, 0x5e, 0xde, 0xee, 0xd6 };
-            memcpy(cart->bank0.palette.vbank0.data, DB16, sizeof DB16);
+            if(image->width == TIC80_WIDTH && image->height == TIC80_HEIGHT)
+                for (s32 i = 0; i < TIC80_WIDTH * TIC80_HEIGHT; i++)
+                    tic_tool_poke4(screen->data, i, 
+                        tic_nearest_color(palette->colors, (const tic_rgb*)&image->palette[image->buffer[i]], TIC_PALETTE_SIZE));
+
+            gif_close(image);
         }
-#endif
     }
+}
+#endif
 
-    struct CodeChunk {s32 size; const char* data;} code[TIC_BANKS] = {0};
-    struct BinaryChunk {s32 size; const char* data;} binary[TIC_BINARY_BANKS] = {0};
+static_assert(sizeof(tic_bank) == sizeof(tic_screen) + sizeof(tic_tiles) + sizeof(tic_sprites) + sizeof(tic_map) 
+    + sizeof(tic_sfx) + sizeof(tic_music) + sizeof(tic_flags) + sizeof(tic_palettes), "tic_bank_sections");
 
+static_assert(sizeof(tic_cartridge) == sizeof(tic_bank) * TIC_BANKS + sizeof(tic_code) + sizeof(tic_binary), "tic_cartridge_sections");
+
+void tic_cart_load(tic_cartridge* cart, const u8* buffer, s32 size)
+{
+    ChunkIndex index = {0};
+
+    indexChunks(index, buffer, size);
+
+#define LOAD_SECTION(to, type) loadSection(&to, sizeof(to), &index[type][bank])
+
+    for(s32 bank = 0; bank < TIC_BANKS; bank++)
     {
-        const u8* ptr = buffer;
-        while(ptr < end)
-        {
-            const Chunk* chunk = (Chunk*)ptr;
-            ptr += sizeof(Chunk);
-
-            switch(chunk->type)
-            {
-            case CHUNK_TILES:       LOAD_CHUNK(cart->banks[chunk->bank].tiles);             break;
-            case CHUNK_SPRITES:     LOAD_CHUNK(cart->banks[chunk->bank].sprites);           break;
-            case CHUNK_MAP:         LOAD_CHUNK(cart->banks[chunk->bank].map);               break;
-            case CHUNK_SAMPLES:     LOAD_CHUNK(cart->banks[chunk->bank].sfx.samples);       break;
-            case CHUNK_WAVEFORM:    LOAD_CHUNK(cart->banks[chunk->bank].sfx.waveforms);     break;
-            case CHUNK_MUSIC:       LOAD_CHUNK(cart->banks[chunk->bank].music.tracks);      break;
-            case CHUNK_PATTERNS:    LOAD_CHUNK(cart->banks[chunk->bank].music.patterns);    break;
-            case CHUNK_FLAGS:       LOAD_CHUNK(cart->banks[chunk->bank].flags);             break;
-            case CHUNK_SCREEN:      LOAD_CHUNK(cart->banks[chunk->bank].screen);            break;
-            case CHUNK_BINARY:      
-                binary[chunk->bank] = (struct BinaryChunk){chunkSize(chunk), ptr};
-                break;
-            case CHUNK_CODE:        
-                code[chunk->bank] = (struct CodeChunk){chunkSize(chunk), ptr};
-                break;
-#if defined(DEPRECATED_CHUNKS)
-            case CHUNK_CODE_ZIP:
-                tic_tool_unzip(cart->code.data, TIC_CODE_SIZE, ptr, chunk->size);
-                break;
-            case CHUNK_COVER_DEP:
-                {
-                    // workaround to load deprecated cover section
-                    gif_image* image = gif_read_data(ptr, chunk->size);
+        tic_bank* dst = &cart->banks[bank];
+        bool defaults = index[CHUNK_DEFAULT][bank].data != NULL;
 
-                    if (image)
-                    {
-                        if(image->width == TIC80_WIDTH && image->height == TIC80_HEIGHT)
-                            for (s32 i = 0; i < TIC80_WIDTH * TIC80_HEIGHT; i++)
-                                tic_tool_poke4(cart->bank0.screen.data, i, 
-                                    tic_nearest_color(cart->bank0.palette.vbank0.colors, (const tic_rgb*)&image->palette[image->buffer[i]], TIC_PALETTE_SIZE));
+        loadPalette(&dst->palette, index, bank);
 
-                        gif_close(image);
-                    }
-                }
-                break;
-            case CHUNK_PATTERNS_DEP: 
-                {
-                    // workaround to load deprecated music patterns section
-                    // and automatically convert volume value to a command
-                    tic_patterns* ptrns = &cart->banks[chunk->bank].music.patterns;
-                    LOAD_CHUNK(*ptrns);
-                    for(s32 i = 0; i < MUSIC_PATTERNS; i++)
-                        for(s32 r = 0; r < MUSIC_PATTERN_ROWS; r++)
-                        {
-                            tic_track_row* row = &ptrns->data[i].rows[r];
-                            if(row->note >= NoteStart && row->command == tic_music_cmd_empty)
-                            {
-                                row->command = tic_music_cmd_volume;
-                                row->param2 = row->param1 = MAX_VOLUME - row->param1;
-                            }
-                        }
-                }
-                break;
-#endif
-            default: break;
-            }
+        if(index[CHUNK_WAVEFORM][bank].data || !defaults)
+            LOAD_SECTION(dst->sfx.waveforms, CHUNK_WAVEFORM);
+        else loadSection(&dst->sfx.waveforms, sizeof dst->sfx.waveforms, &(ChunkRef){Waveforms, sizeof Waveforms});
 
-            ptr += chunkSize(chunk);
-        }
-#undef LOAD_CHUNK
+        LOAD_SECTION(dst->tiles,           CHUNK_TILES);
+        LOAD_SECTION(dst->sprites,         CHUNK_SPRITES);
+        LOAD_SECTION(dst->map,             CHUNK_MAP);
+        LOAD_SECTION(dst->sfx.samples,     CHUNK_SAMPLES);
+        LOAD_SECTION(dst->music.tracks,    CHUNK_MUSIC);
+        LOAD_SECTION(dst->flags,           CHUNK_FLAGS);
+        LOAD_SECTION(dst->screen,          CHUNK_SCREEN);
 
+#if defined(DEPRECATED_CHUNKS)
+        if(!index[CHUNK_PATTERNS][bank].data && index[CHUNK_PATTERNS_DEP][bank].data)
         {
-            u32 total_size = 0;
-            char* ptr = cart->binary.data;
-            RFOR(const struct BinaryChunk*, chunk, binary)
-                if (chunk->size)
+            // workaround to load deprecated music patterns section
+            // and automatically convert volume value to a command
+            tic_patterns* ptrns = &dst->music.patterns;
+            LOAD_SECTION(*ptrns, CHUNK_PATTERNS_DEP);
+            for(s32 i = 0; i < MUSIC_PATTERNS; i++)
+                for(s32 r = 0; r < MUSIC_PATTERN_ROWS; r++)
                 {
-                    memcpy(ptr, chunk->data, chunk->size);
-                    ptr += chunk->size;
-                    total_size += chunk->size;
+                    tic_track_row* row = &ptrns->data[i].rows[r];
+                    if(row->note >= NoteStart && row->command == tic_music_cmd_empty)
+                    {
+                        row->command = tic_music_cmd_volume;
+                        row->param2 = row->param1 = MAX_VOLUME - row->param1;
+                    }
                 }
-            cart->binary.size = total_size;
         }
+        else
+#endif
+        LOAD_SECTION(dst->music.patterns,  CHUNK_PATTERNS);
+    }
+
+#undef LOAD_SECTION
+
+#if defined(DEPRECATED_CHUNKS)
+    loadDeprecatedCover(&cart->bank0.screen, &cart->bank0.palette.vbank0, index);
+#endif
+
+    {
+        s32 total = 0;
+
+        for(s32 bank = TIC_BINARY_BANKS - 1; bank >= 0; bank--)
+            total += readChunk(cart->binary.data + total, sizeof cart->binary.data - total, &index[CHUNK_BINARY][bank]);
+
+        memset(cart->binary.data + total, 0, sizeof cart->binary.data - total);
+        cart->binary.size = total;
+    }
+
+    {
+        s32 total = 0;
+
+#if defined(DEPRECATED_CHUNKS)
+        const ChunkRef* zip = &index[CHUNK_CODE_ZIP][0];
+
+        if(zip->data)
+            total = tic_tool_unzip(cart->code.data, TIC_CODE_SIZE, zip->data, zip->size);
 
-        if (!*cart->code.data)
+        if(total == 0 || !*cart->code.data)
+#endif
         {
-            char* ptr = cart->code.data;
-            RFOR(const struct CodeChunk*, chunk, code)
-                if (chunk->data)
-                {
-                    memcpy(ptr, chunk->data, chunk->size);
-                    ptr += chunk->size;
-                }
+            total = 0;
+
+            for(s32 bank = TIC_BANKS - 1; bank >= 0; bank--)
+                total += readChunk(cart->code.data + total, TIC_CODE_SIZE - total, &index[CHUNK_CODE][bank]);
         }
+
+        memset(cart->code.data + total, 0, TIC_CODE_SIZE - total);
     }
 }
 
+bool tic_cart_cover(const u8* buffer, s32 size, tic_screen* screen, tic_palette* palette)
+{
+    ChunkIndex index = {0};
+    tic_palettes palettes;
+
+    indexChunks(index, buffer, size);
+
+    loadPalette(&palettes, index, 0);
+    memcpy(palette, &palettes.vbank0, sizeof(tic_palette));
+    loadSection(screen, sizeof(tic_screen), &index[CHUNK_SCREEN][0]);
+
+#if defined(DEPRECATED_CHUNKS)
+    loadDeprecatedCover(screen, palette, index);
+#endif
+
+    return !EMPTY(screen->data) && !EMPTY(palette->data);
+}
+
+s32 tic_cart_chunks(const u8* buffer, s32 size, tic_cart_chunk_callback callback, void* userdata)
+{
+    const u8* ptr = buffer;
+    const u8* end = buffer + size;
+
+    while(end - ptr >= (s32)sizeof(Chunk))
+    {
+        Chunk chunk;
+        memcpy(&chunk, ptr, sizeof chunk);
+
+        const u8* header = ptr;
+        ptr += sizeof(Chunk);
+
+        s32 size = MIN(chunkSize(&chunk), (s32)(end - ptr));
+
+        if(!callback(header, ptr, size, userdata))
+            return -1;
+
+        ptr += size;
+    }
+
+    return (s32)(ptr - buffer);
+}
 
 static s32 calcBufferSize(const void* buffer, s32 size)
 {
@@ -249,18 +343,39 @@ static u8* saveFixedChunk(u8* buffer, ChunkType type, const void* from, s32 size
     return buffer;
 }
 
-static u8* saveChunk(u8* buffer, ChunkType type, const void* from, s32 size, s32 bank)
+// deflates the chunk when it gets smaller, otherwise stores it as is
+static u8* savePackedChunk(u8* buffer, ChunkType type, const void* from, s32 size, s32 bank, bool packed)
+{
+    enum {MinPackedSize = 64};
+
+    if(packed && size >= MinPackedSize)
+    {
+        s32 packed = tic_tool_zip(buffer + sizeof(Chunk), MIN(size, TIC_BANK_SIZE) - 1, from, size);
+
+        if(packed > 0)
+        {
+            Chunk chunk = {.type = CHUNK_COMPRESSED, .bank = bank, .size = packed, .temp = type};
+            memcpy(buffer, &chunk, sizeof(Chunk));
+
+            return buffer + sizeof(Chunk) + packed;
+        }
+    }
+
+    return saveFixedChunk(buffer, type, from, size, bank);
+}
+
+static u8* saveChunk(u8* buffer, ChunkType type, const void* from, s32 size, s32 bank, bool packed)
 {
     s32 chunkSize = calcBufferSize(from, size);
 
-    return saveFixedChunk(buffer, type, from, chunkSize, bank);
+    return savePackedChunk(buffer, type, from, chunkSize, bank, packed);
 }
 
-s32 tic_cart_save(const tic_cartridge* cart, u8* buffer)
+static s32 saveCart(const tic_cartridge* cart, u8* buffer, bool packed)
 {
     u8* start = buffer;
 
-#define SAVE_CHUNK(ID, FROM, BANK) saveChunk(buffer, ID, &FROM, sizeof(FROM), BANK)
+#define SAVE_CHUNK(ID, FROM, BANK) saveChunk(buffer, ID, &FROM, sizeof(FROM), BANK, packed)
 
     tic_waveforms defaultWaveforms = {0};
     tic_palettes defaultPalettes = {0};
@@ -300,16 +415,26 @@ s32 tic_cart_save(const tic_cartridge* cart, u8* buffer)
         s32 remaining = cart->binary.size;
         for (s32 i = cart->binary.size / TIC_BANK_SIZE; i >= 0; --i, ptr += TIC_BANK_SIZE) 
         {
-            buffer = saveFixedChunk(buffer, CHUNK_BINARY, ptr, MIN(remaining, TIC_BANK_SIZE), i);
+            buffer = savePackedChunk(buffer, CHUNK_BINARY, ptr, MIN(remaining, TIC_BANK_SIZE), i, packed);
             remaining -= TIC_BANK_SIZE;
         }
     }
 
     ptr = cart->code.data;
     for(s32 i = strlen(ptr) / TIC_BANK_SIZE; i >= 0; --i, ptr += TIC_BANK_SIZE)
-        buffer = saveFixedChunk(buffer, CHUNK_CODE, ptr, MIN(strlen(ptr), TIC_BANK_SIZE), i);
+        buffer = savePackedChunk(buffer, CHUNK_CODE, ptr, MIN(strlen(ptr), TIC_BANK_SIZE), i, packed);
 
 #undef SAVE_CHUNK
 
     return (s32)(buffer - start);
 }
+
+s32 tic_cart_save(const tic_cartridge* cart, u8* buffer)
+{
+    return saveCart(cart, buffer, false);
+}
+
+s32 tic_cart_save_packed(const tic_cartridge* cart, u8* buffer)
+{
+    return saveCart(cart, buffer, true);
+}
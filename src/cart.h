@@ -26,3 +26,17 @@
 
 void tic_cart_load(tic_cartridge* rom, const u8* buffer, s32 size);
 s32  tic_cart_save(const tic_cartridge* rom, u8* buffer);
+
+// deflates the chunks where it makes them smaller,
+// older versions skip such chunks and load the cart empty, so it's opt-in
+s32  tic_cart_save_packed(const tic_cartridge* rom, u8* buffer);
+
+// reads only the bank 0 screen and palette, returns false if the cart has no cover
+bool tic_cart_cover(const u8* buffer, s32 size, tic_screen* screen, tic_palette* palette);
+
+#define TIC_CHUNK_HEADER_SIZE 4
+
+// calls back with the raw header and the data of every chunk in the buffer,
+// returns the number of bytes walked or -1 if the callback stopped the walk
+typedef bool(*tic_cart_chunk_callback)(const u8* header, const u8* data, s32 size, void* userdata);
+s32 tic_cart_chunks(const u8* buffer, s32 size, tic_cart_chunk_callback callback, void* userdata);
@@ -380,9 +380,13 @@ static void tic_close_current_vm(tic_core* core)
         core->currentScript->close( (tic_mem*)core );
         core->currentVM = NULL;
     }
-    if (core->memory.ram == NULL) {
-        core->memory.ram = core->memory.base_ram;
-    }
+}
+
+static void updateRamRefs(tic_core* core)
+{
+    // sfx positions are exposed to the cart through RAM
+    for (s32 i = 0; i < TIC_SOUND_CHANNELS; i++)
+        core->state.sfx.channels[i].pos = &core->memory.ram->sfxpos[i];
 }
 
 static bool tic_init_vm(tic_core* core, const char* code, const tic_script_config* config)
@@ -391,6 +395,10 @@ static bool tic_init_vm(tic_core* core, const char* code, const tic_script_confi
     // set current script config and init
     core->currentScript = config;
     bool done = config->init( (tic_mem*) core , code);
+
+    // VM could map RAM into its own memory
+    updateRamRefs(core);
+
     if(!done)
     {
         // if it couldn't init, make sure the VM is not left dirty by the implementation
@@ -476,7 +484,19 @@ void tic_core_tick(tic_mem* tic, tic_tick_data* data)
         else return;
     }
 
+    clock_t start = tic_core_clock();
+
     core->state.tick(tic);
+
+    if (core->currentVM && core->currentScript->gc)
+    {
+        // leave half of the frame slack for the rest of the frame
+        s64 slack = (s64)(CLOCKS_PER_SEC / TIC80_FRAMERATE) - (s64)(tic_core_clock() - start);
+
+        start = tic_core_clock();
+        core->currentScript->gc(tic, (clock_t)MAX(slack / 2, 0));
+        tic->gc.time = tic_core_clock() - start;
+    }
 }
 
 void tic_core_pause(tic_mem* memory)
@@ -505,6 +525,33 @@ void tic_core_resume(tic_mem* memory)
     }
 }
 
+// wall time in clock() units, clock() counts the CPU time of all the threads on POSIX
+clock_t tic_core_clock()
+{
+#if !defined(_WIN32) && defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    if(clock_gettime(CLOCK_MONOTONIC, &ts) == 0)
+        return (clock_t)((s64)ts.tv_sec * CLOCKS_PER_SEC + (s64)ts.tv_nsec * CLOCKS_PER_SEC / 1000000000);
+#endif
+
+    return clock();
+}
+
+// applies the current cart code to the paused VM, called on resume only
+bool tic_core_reload(tic_mem* memory)
+{
+    tic_core* core = (tic_core*)memory;
+    const tic_script_config* config = core->currentScript;
+
+    if (core->data && core->currentVM && core->state.initialized 
+        && config == tic_core_script_config(memory) && config->reload)
+    {
+        return config->reload(memory, memory->cart.code.data);
+    }
+
+    return true;
+}
+
 void tic_core_close(tic_mem* memory)
 {
     tic_core* core = (tic_core*)memory;
@@ -513,6 +560,9 @@ void tic_core_close(tic_mem* memory)
 
     tic_close_current_vm(core);
 
+    free(core->vmram);
+    free(memory->base_ram);
+
     blip_delete(core->blip.left);
     blip_delete(core->blip.right);
 
@@ -172,6 +172,17 @@ typedef struct
     void* currentVM;
     const tic_script_config* currentScript;
 
+    // the collector mode applied to the VM
+    struct
+    {
+        void* vm;
+        tic_gc_mode mode;
+    } gc;
+
+    // VM memory block the RAM is mapped into (WASM linear memory),
+    // it outlives the VM so RAM doesn't move between runs
+    void* vmram;
+
     struct
     {
         blip_buffer_t* left;
@@ -199,6 +210,7 @@ typedef struct
 void tic_core_tick_io(tic_mem* memory);
 void tic_core_sound_tick_start(tic_mem* memory);
 void tic_core_sound_tick_end(tic_mem* memory);
+clock_t tic_core_clock();
 
 // mouse cursor is the same in both modes
 // for backward compatibility
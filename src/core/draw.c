@@ -806,6 +806,61 @@ void tic_api_textri(tic_mem* tic, float x1, float y1, float x2, float y2, float
                 : triTexTileShader, &texData);
 }
 
+s32 tic_api_mesh(tic_mem* tic, const float* vertices, s32 count, const float* matrix, tic_texture_src texsrc, u8* colors, s32 colorsCount, bool cull)
+{
+    // vertices closer than that to the camera plane are treated as behind it
+    const double Near = 1e-5;
+
+    TexData texData = 
+    {
+        .sheet = getTileSheetFromSegment(tic, tic->ram->vram.blit.segment),
+        .mapping = getPalette(tic, colors, colorsCount),
+        .map = tic->ram->map.data,
+        .vram = &((tic_core*)tic)->state.vbank.mem,
+    };
+
+    PixelShader shader = texsrc == tic_vbank_texture 
+        ? triTexVbankShader 
+        : texsrc == tic_map_texture 
+            ? triTexMapShader 
+            : triTexTileShader;
+
+    const float* m = matrix;
+    s32 drawn = 0;
+
+    for(s32 i = 0; i + 3 <= count; i += 3)
+    {
+        TexVert tri[3];
+        bool visible = true;
+
+        for(s32 j = 0; j != 3 && visible; ++j)
+        {
+            const float* v = vertices + (i + j) * TIC_MESH_VERTEX;
+
+            double x = m[0]  * v[0] + m[1]  * v[1] + m[2]  * v[2] + m[3];
+            double y = m[4]  * v[0] + m[5]  * v[1] + m[6]  * v[2] + m[7];
+            double w = m[12] * v[0] + m[13] * v[1] + m[14] * v[2] + m[15];
+
+            if(w < Near)
+                visible = false;
+            else tri[j] = (TexVert)
+            {
+                {(1.0 + x / w) * TIC80_WIDTH / 2, (1.0 - y / w) * TIC80_HEIGHT / 2},
+                v[3], v[4],
+            };
+        }
+
+        // front faces are counter-clockwise in clip space, clockwise on the screen
+        if(!visible || (cull && edgeFn(&tri[0]._, &tri[1]._, &tri[2]._) >= 0.0))
+            continue;
+
+        drawTri(tic, &tri[0]._, &tri[1]._, &tri[2]._, shader, &texData);
+        drawn++;
+    }
+
+    return drawn;
+}
+
 void tic_api_map(tic_mem* memory, s32 x, s32 y, s32 width, s32 height, s32 sx, s32 sy, u8* colors, u8 count, s32 scale, RemapFunc remap, void* data)
 {
     drawMap((tic_core*)memory, &memory->ram->map, x, y, width, height, sx, sy, colors, count, scale, remap, data);
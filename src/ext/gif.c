@@ -285,137 +285,400 @@ static const u8* toColor(const u8* ptr, gif_color* color)
     return ptr;
 }
 
-bool gif_write_animation(const void* buffer, s32* size, s32 width, s32 height, const u8* data, s32 frames, s32 fps, s32 scale)
+static s32 writeMemory(void* data, const u8* buffer, s32 size)
 {
-    bool result = false;
+    GifBuffer* output = (GifBuffer*)data;
 
-    s32 swidth = width*scale, sheight = height*scale;
-    s32 frameSize = width * height;
+    memcpy((u8*)output->data + output->pos, buffer, size);
+    output->pos += size;
 
-    enum{Bpp = 8, PalSize = 1 << Bpp, PalStructSize = PalSize * sizeof(gif_color)};
+    return size;
+}
 
-    s32 error = 0;
-    GifBuffer output = {buffer, 0};
-    GifFileType* gif = EGifOpen(&output, writeBuffer, &error);
+enum{Bpp = 8, PalSize = 1 << Bpp, HashSize = PalSize * 4};
 
-    if(gif)
-    {           
-        EGifSetGifVersion(gif, true);
+// colors of a frame with a hash index, the last index of the table is reserved for transparency
+typedef struct
+{
+    gif_color colors[PalSize];
+    s32 count;
+
+    struct
+    {
+        u32 key;
+        s32 index;
+    } hash[HashSize];
+} GifPalette;
+
+struct gif_writer
+{
+    GifFileType* gif;
+
+    gif_write_callback write;
+    void* data;
+
+    s32 width;
+    s32 height;
+    s32 scale;
+
+    // last written frame and the next one, waiting until its delay is known
+    u32* prev;
+    u32* next;
+    s32 delay;
+    bool written;
+    bool pending;
+
+    // global color table is made of the first frame colors,
+    // frames using other colors get a local table
+    GifPalette global;
+    GifPalette local;
+
+    u8* screen;
+    u8* line;
+
+    bool error;
+};
+
+static s32 writeStream(GifFileType* gif, const GifByteType* data, s32 size)
+{
+    gif_writer* writer = (gif_writer*)gif->UserData;
 
-        if(EGifPutScreenDesc(gif, swidth, sheight, Bpp, 0, NULL) != GIF_ERROR)
+    return writer->write(writer->data, data, size);
+}
+
+static inline u32 hashColor(u32 key)
+{
+    key ^= key >> 16;
+    key *= 0x45d9f3b;
+    key ^= key >> 16;
+
+    return key & (HashSize - 1);
+}
+
+static void resetPalette(GifPalette* palette)
+{
+    palette->count = 0;
+
+    for(s32 i = 0; i < HashSize; i++)
+        palette->hash[i].index = -1;
+}
+
+static u8 findColor(GifPalette* palette, u32 key)
+{
+    u32 slot = hashColor(key);
+
+    for(; palette->hash[slot].index >= 0; slot = (slot + 1) & (HashSize - 1))
+        if(palette->hash[slot].key == key)
+            return palette->hash[slot].index;
+
+    gif_color color;
+    toColor((const u8*)&key, &color);
+
+    if(palette->count < PalSize - 1)
+    {
+        palette->hash[slot].key = key;
+        palette->hash[slot].index = palette->count;
+        palette->colors[palette->count] = color;
+
+        return palette->count++;
+    }
+
+    // the palette is full, use the closest color
+    s32 closest = 0, minDist = INT32_MAX;
+    for(s32 c = 0; c < palette->count; c++)
+    {
+        s32 r = palette->colors[c].r - color.r, g = palette->colors[c].g - color.g, b = palette->colors[c].b - color.b;
+        s32 dist = r*r + g*g + b*b;
+
+        if(dist < minDist)
         {
-            if(AddLoop(gif))
-            {
-                gif_color* palette = (gif_color*)malloc(PalStructSize);                 
-                u8* screen = malloc(frameSize);
-                u8* line = malloc(swidth);
+            minDist = dist;
+            closest = c;
+        }
+    }
 
-                for(s32 f = 0; f < frames; f++)
-                {
-                    enum {DelayUnits = 100, MinDelay = 2};
+    return closest;
+}
 
-                    s32 frame = (f * fps * MinDelay * 2 + 1) / (2 * DelayUnits);
+static ColorMapObject* makeColorMap(const GifPalette* palette)
+{
+    s32 bpp = 1;
+    while((1 << bpp) < palette->count + 1) bpp++;
 
-                    if(frame >= frames)
-                        break;
+    ColorMapObject* colorMap = GifMakeMapObject(1 << bpp, NULL);
+    memset(colorMap->Colors, 0, (1 << bpp) * sizeof(GifColorType));
+    memcpy(colorMap->Colors, palette->colors, palette->count * sizeof(GifColorType));
 
-                    s32 colors = 0;
-                    const u8* ptr = data + frameSize*frame*sizeof(u32);
-                    
-                    {
-                        memset(palette, 0, PalStructSize);
-                        memset(screen, 0, frameSize);
+    return colorMap;
+}
 
-                        for(s32 i = 0; i < frameSize; i++)
-                        {
-                            if(colors >= PalSize) break;
+// writes the next frame as a difference with the previous one,
+// only the changed rectangle is written and the unchanged pixels in it are transparent
+static bool writeFrame(gif_writer* writer)
+{
+    const s32 width = writer->width, height = writer->height, scale = writer->scale;
+    const u32* next = writer->next;
+    const u32* prev = writer->written ? writer->prev : NULL;
 
-                            gif_color color;
-                            toColor(ptr + i*sizeof(u32), &color);
+    s32 l = 0, t = 0, r = width - 1, b = height - 1;
 
-                            bool found = false;
-                            for(s32 c = 0; c < colors; c++)
-                            {
-                                if(memcmp(&palette[c], &color, sizeof(gif_color)) == 0)
-                                {
-                                    found = true;
-                                    screen[i] = c;
-                                    break;
-                                }
-                            }
+    if(prev)
+    {
+        l = width, t = height, r = -1, b = -1;
 
-                            if(!found)
-                            {
-                                // TODO: check for last color in palette and try to find closest color
-                                screen[i] = colors;
-                                memcpy(&palette[colors], &color, sizeof(gif_color));
-                                colors++;
-                            }
-                        }
-                    }
+        for(s32 y = 0, i = 0; y < height; y++)
+            for(s32 x = 0; x < width; x++, i++)
+                if(next[i] != prev[i])
+                {
+                    if(x < l) l = x;
+                    if(x > r) r = x;
+                    if(y < t) t = y;
+                    b = y;
+                }
+
+        if(r < 0)
+            l = t = r = b = 0;
+    }
 
+    s32 w = r - l + 1, h = b - t + 1;
+
+    GifPalette* palette = &writer->local;
+    memcpy(palette, &writer->global, sizeof(GifPalette));
+
+    bool transparent = false;
+
+    {
+        u32 lastKey = 0;
+        u8 lastIndex = 0;
+        bool last = false;
+
+        for(s32 y = t, i = 0; y <= b; y++)
+            for(s32 x = l, pos = y * width + l; x <= r; x++, pos++, i++)
+            {
+                u32 key = next[pos];
+
+                if(prev && key == prev[pos])
+                {
+                    writer->screen[i] = PalSize - 1;
+                    transparent = true;
+                }
+                else
+                {
+                    if(!last || key != lastKey)
                     {
-                        GraphicsControlBlock gcb = 
-                        {
-                            .DisposalMode = DISPOSE_DO_NOT,
-                            .UserInputFlag = false,
-                            .DelayTime = MinDelay,
-                            .TransparentColor = -1,
-                        };
-
-                        u8 ext[4];
-                        EGifGCBToExtension(&gcb, ext);
-                        EGifPutExtension(gif, GRAPHICS_EXT_FUNC_CODE, sizeof ext, ext);
+                        lastKey = key;
+                        lastIndex = findColor(palette, key);
+                        last = true;
                     }
 
-                    ColorMapObject* colorMap = GifMakeMapObject(PalSize, NULL);
-                    memset(colorMap->Colors, 0, PalStructSize);
-                    memcpy(colorMap->Colors, palette, colors * sizeof(GifColorType));
+                    writer->screen[i] = lastIndex;
+                }
+            }
+    }
 
-                    if(EGifPutImageDesc(gif, 0, 0, swidth, sheight, false, colorMap) != GIF_ERROR)
-                    {
-                        for(s32 y = 0; y < height; y++)
-                        {
-                            for(s32 x = 0, pos = y*width; x < width; x++, pos++)
-                            {
-                                u8 color = screen[pos];
-                                for(s32 s = 0, pos = x*scale; s < scale; s++, pos++)
-                                    line[pos] = color;
-                            }
+    s32 error = E_GIF_SUCCEEDED;
+    ColorMapObject* colorMap = makeColorMap(palette);
+    s32 transparentIndex = colorMap->ColorCount - 1;
 
-                            for(s32 s = 0; s < scale; s++)
-                            {
-                                if (EGifPutLine(gif, line, swidth) == GIF_ERROR)
-                                {
-                                    error = gif->Error;
-                                    break;
-                                }
-                            }
+    if(!writer->written)
+    {
+        // the first frame colors make the global table
+        memcpy(&writer->global, palette, sizeof(GifPalette));
 
-                            if(error != E_GIF_SUCCEEDED) break;
-                        }
+        if(EGifPutScreenDesc(writer->gif, width * scale, height * scale, Bpp, 0, colorMap) == GIF_ERROR
+            || !AddLoop(writer->gif))
+            error = writer->gif->Error;
 
-                        *size = output.pos;
+        GifFreeMapObject(colorMap);
+        colorMap = NULL;
+    }
+    else if(palette->count == writer->global.count)
+    {
+        GifFreeMapObject(colorMap);
+        colorMap = NULL;
+    }
 
-                        result = error == E_GIF_SUCCEEDED;
-                    }
+    if(transparent && transparentIndex != PalSize - 1)
+        for(s32 i = 0, size = w * h; i < size; i++)
+            if(writer->screen[i] == PalSize - 1)
+                writer->screen[i] = transparentIndex;
+
+    {
+        GraphicsControlBlock gcb = 
+        {
+            .DisposalMode = DISPOSE_DO_NOT,
+            .UserInputFlag = false,
+            .DelayTime = writer->delay,
+            .TransparentColor = transparent ? transparentIndex : NO_TRANSPARENT_COLOR,
+        };
 
-                    GifFreeMapObject(colorMap);
+        u8 ext[4];
+        EGifGCBToExtension(&gcb, ext);
+        EGifPutExtension(writer->gif, GRAPHICS_EXT_FUNC_CODE, sizeof ext, ext);
+    }
 
-                    if(!result)
-                        break;
+    if(error == E_GIF_SUCCEEDED)
+    {
+        if(EGifPutImageDesc(writer->gif, l * scale, t * scale, w * scale, h * scale, false, colorMap) != GIF_ERROR)
+        {
+            for(s32 y = 0; y < h && error == E_GIF_SUCCEEDED; y++)
+            {
+                for(s32 x = 0, pos = y * w; x < w; x++, pos++)
+                {
+                    u8 color = writer->screen[pos];
+                    for(s32 s = 0, pos = x*scale; s < scale; s++, pos++)
+                        writer->line[pos] = color;
                 }
 
-                free(line);
-                free(screen);
-                free(palette);
+                for(s32 s = 0; s < scale; s++)
+                {
+                    if (EGifPutLine(writer->gif, writer->line, w * scale) == GIF_ERROR)
+                    {
+                        error = writer->gif->Error;
+                        break;
+                    }
+                }
             }
         }
+        else error = writer->gif->Error;
+    }
 
-        EGifCloseFile(gif, &error);
+    if(colorMap)
+        GifFreeMapObject(colorMap);
+
+    {
+        u32* last = writer->prev;
+        writer->prev = writer->next;
+        writer->next = last;
+    }
+
+    writer->written = true;
+    writer->pending = false;
+
+    return error == E_GIF_SUCCEEDED;
+}
 
-        *size = output.pos;
+gif_writer* gif_writer_open(s32 width, s32 height, s32 scale, gif_write_callback write, void* data)
+{
+    gif_writer* writer = calloc(1, sizeof(gif_writer));
+
+    if(writer)
+    {
+        writer->write = write;
+        writer->data = data;
+        writer->width = width;
+        writer->height = height;
+        writer->scale = scale;
+        writer->prev = malloc(width * height * sizeof(u32));
+        writer->next = malloc(width * height * sizeof(u32));
+        writer->screen = malloc(width * height);
+        writer->line = malloc(width * scale);
+
+        resetPalette(&writer->global);
+
+        s32 error = 0;
+        writer->gif = EGifOpen(writer, writeStream, &error);
+
+        if(writer->gif)
+        {
+            // the screen descriptor is written with the first frame
+            EGifSetGifVersion(writer->gif, true);
+            return writer;
+        }
+
+        writer->error = true;
+        gif_writer_close(writer);
     }
 
+    return NULL;
+}
+
+bool gif_writer_frame(gif_writer* writer, const u8* data, s32 delay)
+{
+    s32 size = writer->width * writer->height * sizeof(u32);
+
+    if(writer->error)
+        return false;
+
+    // identical frames are merged into one with a longer delay
+    if(writer->pending && memcmp(writer->next, data, size) == 0)
+    {
+        writer->delay += delay;
+        return true;
+    }
+
+    if(writer->pending && !writeFrame(writer))
+    {
+        writer->error = true;
+        return false;
+    }
+
+    memcpy(writer->next, data, size);
+    writer->delay = delay;
+    writer->pending = true;
+
+    return true;
+}
+
+bool gif_writer_close(gif_writer* writer)
+{
+    if(writer->pending && !writeFrame(writer))
+        writer->error = true;
+
+    if(writer->gif)
+    {
+        s32 error = 0;
+
+        if(!writer->written)
+        {
+            ColorMapObject* colorMap = makeColorMap(&writer->global);
+
+            if(EGifPutScreenDesc(writer->gif, writer->width * writer->scale, writer->height * writer->scale, Bpp, 0, colorMap) == GIF_ERROR)
+                writer->error = true;
+
+            GifFreeMapObject(colorMap);
+        }
+
+        if(EGifCloseFile(writer->gif, &error) == GIF_ERROR)
+            writer->error = true;
+    }
+
+    bool result = !writer->error;
+
+    free(writer->prev);
+    free(writer->next);
+    free(writer->screen);
+    free(writer->line);
+    free(writer);
+
     return result;
-}
\ No newline at end of file
+}
+
+bool gif_write_animation(const void* buffer, s32* size, s32 width, s32 height, const u8* data, s32 frames, s32 fps, s32 scale)
+{
+    GifBuffer output = {buffer, 0};
+    gif_writer* writer = gif_writer_open(width, height, scale, writeMemory, &output);
+
+    bool result = writer != NULL;
+
+    if(writer)
+    {
+        for(s32 f = 0; result; f++)
+        {
+            enum {DelayUnits = 100, MinDelay = 2};
+
+            s32 frame = (f * fps * MinDelay * 2 + 1) / (2 * DelayUnits);
+
+            if(frame >= frames)
+                break;
+
+            result = gif_writer_frame(writer, data + width * height * frame * sizeof(u32), MinDelay);
+        }
+
+        result = gif_writer_close(writer) && result;
+    }
+
+    *size = output.pos;
+
+    return result;
+}
@@ -47,3 +47,11 @@ gif_image* gif_read_data(const void* buffer, s32 size);
 bool gif_write_data(const void* buffer, s32* size, s32 width, s32 height, const u8* data, const gif_color* palette, u8 bpp);
 bool gif_write_animation(const void* buffer, s32* size, s32 width, s32 height, const u8* data, s32 frames, s32 fps, s32 scale);
 void gif_close(gif_image* image);
+
+// streaming writer, frames are RGBA and delays are in 1/100 s
+typedef struct gif_writer gif_writer;
+typedef s32(*gif_write_callback)(void* data, const u8* buffer, s32 size);
+
+gif_writer* gif_writer_open(s32 width, s32 height, s32 scale, gif_write_callback write, void* data);
+bool gif_writer_frame(gif_writer* writer, const u8* data, s32 delay);
+bool gif_writer_close(gif_writer* writer);
@@ -21,17 +21,29 @@
 // SOFTWARE.
 
 #include "history.h"
+#include "tools.h"
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 
+// unchanged bytes that still join two changed ranges into one
+#define HISTORY_GAP 16
+
+// the buffer is compared in blocks and only the changed blocks are scanned bytewise
+#define HISTORY_BLOCK 64
+
+// steps next to the last added one are kept unzipped
+#define HISTORY_RECENT 8
+
+// memory for the steps of all the histories, the oldest steps are dropped over it
+#define HISTORY_BUDGET (32 * 1024 * 1024)
+
 typedef struct
 {
-    u8* buffer;
     u32 start;
-    u32 end;
-} Data;
+    u32 size;
+} Range;
 
 typedef struct Item Item;
 
@@ -40,74 +52,270 @@ struct Item
     Item* next;
     Item* prev;
 
-    Data data;
+    // order of the steps of all the histories
+    u64 id;
+
+    Range* ranges;
+    u32 count;
+
+    // xor of the ranges before and after the step
+    u8* buffer;
+    u32 size;
+
+    // size of the zipped buffer or 0
+    u32 zipped;
+    bool packed;
+};
+
+struct History
+{
+    // first item is an empty step, the current one is the last applied
+    Item* first;
+    Item* list;
+
+    u32 size;
+    u8* state;
+
+    void* data;
+
+    // ranges the next step is limited to
+    Range* marks;
+    u32 markCount;
+    u32 markCapacity;
+
+    History* next;
 };
 
-static void list_delete(Item* list, Item* from)
+static struct
+{
+    History* list;
+    u64 memory;
+    u64 id;
+} Histories;
+
+static u64 itemMemory(const Item* item)
+{
+    return sizeof(Item) + item->count * sizeof(Range) + (item->zipped ? item->zipped : item->size);
+}
+
+static void item_delete(Item* item)
+{
+    Histories.memory -= itemMemory(item);
+
+    free(item->ranges);
+    free(item->buffer);
+    free(item);
+}
+
+static void list_delete(Item* from)
 {
     Item* it = from;
 
     while(it)
     {
         Item* next = it->next;
-
-        if(it->data.buffer) free(it->data.buffer);
-        
-        free(it);
-
+        item_delete(it);
         it = next;
     }
 }
 
-static Item* list_insert(Item* list, Data* data)
+static void list_insert(History* history, Item* item)
 {
-    Item* item = (Item*)malloc(sizeof(Item));
+    Item* list = history->list;
+
+    list_delete(list->next);
+
+    list->next = item;
+    item->prev = list;
     item->next = NULL;
-    item->prev = NULL;
-    item->data = *data;
 
-    if(list)
+    history->list = item;
+
+    Histories.memory += itemMemory(item);
+}
+
+static bool addRange(Range** ranges, u32* count, u32* capacity, u32 start, u32 end)
+{
+    if(*count)
+    {
+        Range* last = &(*ranges)[*count - 1];
+
+        if(start <= last->start + last->size + HISTORY_GAP)
+        {
+            last->size = end - last->start;
+            return true;
+        }
+    }
+
+    if(*count == *capacity)
+    {
+        u32 size = *capacity ? *capacity * 2 : 8;
+        Range* data = realloc(*ranges, size * sizeof(Range));
+
+        if(!data)
+            return false;
+
+        *ranges = data;
+        *capacity = size;
+    }
+
+    (*ranges)[(*count)++] = (Range){start, end - start};
+
+    return true;
+}
+
+static bool findChanges(const History* history, u32 start, u32 end, Range** ranges, u32* count, u32* capacity)
+{
+    const u8* state = history->state;
+    const u8* data = history->data;
+
+    for(u32 i = start; i < end; i += HISTORY_BLOCK)
     {
-        list_delete(list, list->next);
+        u32 blockEnd = i + HISTORY_BLOCK < end ? i + HISTORY_BLOCK : end;
+
+        if(memcmp(state + i, data + i, blockEnd - i) == 0)
+            continue;
 
-        list->next = item;
-        item->prev = list;
+        for(u32 k = i; k < blockEnd; k++)
+            if(state[k] != data[k] && !addRange(ranges, count, capacity, k, k + 1))
+                return false;
     }
 
-    return item;
+    return true;
 }
 
-static Item* list_first(Item* list)
+static s32 rangecmp(const void* a, const void* b)
 {
-    Item* it = list;
-    while(it->prev) it = it->prev;
+    const Range* ra = a;
+    const Range* rb = b;
 
-    return it;
+    return ra->start < rb->start ? -1 : ra->start > rb->start;
 }
 
-struct History
+static void unzipItem(const Item* item, u8* dst)
 {
-    Item* list;
+    if(item->zipped)
+        tic_tool_unzip(dst, item->size, item->buffer, item->zipped);
+    else memcpy(dst, item->buffer, item->size);
+}
 
-    u32 size;
-    u8* state;
+// zips a step when it isn't one of the recent ones anymore
+static void packItem(Item* item)
+{
+    if(item->packed || item->zipped)
+        return;
 
-    void* data;
-};
+    item->packed = true;
+
+    u8* buffer = malloc(item->size);
+
+    if(buffer)
+    {
+        u32 size = tic_tool_zip(buffer, item->size, item->buffer, item->size);
+
+        if(size && size < item->size)
+        {
+            Histories.memory -= itemMemory(item);
+
+            // the zipped data stays in the bigger block if it can't shrink
+            u8* packed = realloc(buffer, size);
+
+            free(item->buffer);
+            item->buffer = packed ? packed : buffer;
+            item->zipped = size;
+
+            Histories.memory += itemMemory(item);
+            return;
+        }
+
+        free(buffer);
+    }
+}
+
+// drops the oldest steps of all the histories over the budget,
+// a history can't lose the step it's currently at
+static void fitBudget(void)
+{
+    while(Histories.memory > HISTORY_BUDGET)
+    {
+        History* oldest = NULL;
+
+        for(History* it = Histories.list; it; it = it->next)
+        {
+            Item* item = it->first->next;
+
+            if(item && it->list != it->first && (!oldest || item->id < oldest->first->next->id))
+                oldest = it;
+        }
+
+        if(!oldest)
+            break;
+
+        Item* item = oldest->first->next;
+
+        if(oldest->list == item)
+            oldest->list = oldest->first;
+
+        oldest->first->next = item->next;
+
+        if(item->next)
+            item->next->prev = oldest->first;
+
+        item_delete(item);
+    }
+}
+
+// applies the xor of the step to the state and copies the changed ranges to the data
+static void applyItem(History* history, const Item* item)
+{
+    u8* buffer = item->zipped ? malloc(item->size) : item->buffer;
+
+    if(!buffer)
+        return;
+
+    if(item->zipped)
+        unzipItem(item, buffer);
+
+    const u8* ptr = buffer;
+
+    for(const Range *range = item->ranges, *end = range + item->count; range != end; ++range)
+    {
+        u8* state = history->state + range->start;
+
+        for(u32 i = 0; i < range->size; i++)
+            state[i] ^= *ptr++;
+
+        memcpy((u8*)history->data + range->start, state, range->size);
+    }
+
+    if(item->zipped)
+        free(buffer);
+}
+
+// drops the marked changes not added to the history
+static void revertMarks(History* history)
+{
+    for(const Range *range = history->marks, *end = range + history->markCount; range != end; ++range)
+        memcpy((u8*)history->data + range->start, history->state + range->start, range->size);
+
+    history->markCount = 0;
+}
 
 History* history_create(void* data, u32 size)
 {
-    History* history = (History*)malloc(sizeof(History));
+    History* history = (History*)calloc(1, sizeof(History));
     history->data = data;
-
-    history->list = NULL;
     history->size = size;
 
     history->state = malloc(size);
     memcpy(history->state, data, history->size);
 
     // empty diff
-    history->list = list_insert(history->list, &(Data){NULL, 0, 0});
+    history->first = history->list = (Item*)calloc(1, sizeof(Item));
+    Histories.memory += itemMemory(history->first);
+
+    history->next = Histories.list;
+    Histories.list = history;
 
     return history;
 }
@@ -116,79 +324,154 @@ void history_delete(History* history)
 {
     if(history)
     {
+        for(History** it = &Histories.list; *it; it = &(*it)->next)
+            if(*it == history)
+            {
+                *it = history->next;
+                break;
+            }
+
         free(history->state);
+        free(history->marks);
 
-        list_delete(history->list, list_first(history->list));
+        list_delete(history->first);
 
         free(history);
     }
 }
 
-static void history_diff(History* history, Data* data)
+void history_mark(History* history, u32 offset, u32 size)
 {
-    for (u32 i = data->start, k = 0; i < data->end; ++i, ++k)
-        history->state[i] ^= data->buffer[k];
-}
-
-static u32 trim_left(u8* data, u32 size)
-{
-    for(u32 i = 0; i < size; i++)
-        if(data[i]) return i;
+    if(offset >= history->size)
+        return;
 
-    return size;
-}
+    if(size > history->size - offset)
+        size = history->size - offset;
 
-static u32 trim_right(u8* data, u32 size)
-{
-    for(u32 i = 0; i < size; i++)
-        if(data[size - i - 1]) return size - i;
+    if(history->markCount == history->markCapacity)
+    {
+        u32 capacity = history->markCapacity ? history->markCapacity * 2 : 8;
+        Range* marks = realloc(history->marks, capacity * sizeof(Range));
+
+        // without the mark the whole buffer is compared
+        if(!marks)
+        {
+            history->markCount = 0;
+            return;
+        }
+
+        history->marks = marks;
+        history->markCapacity = capacity;
+    }
 
-    return 0;
+    history->marks[history->markCount++] = (Range){offset, size};
 }
 
 bool history_add(History* history)
 {
-    if (memcmp(history->state, history->data, history->size) == 0) return false;
+    Range* ranges = NULL;
+    u32 count = 0;
+    u32 capacity = 0;
+    bool found = true;
 
-    history_diff(history, &(Data){history->data, 0, history->size});
+    if(history->markCount)
+    {
+        qsort(history->marks, history->markCount, sizeof(Range), rangecmp);
+
+        for(u32 i = 0, from = 0; i < history->markCount && found; i++)
+        {
+            const Range* mark = &history->marks[i];
+            u32 start = mark->start > from ? mark->start : from;
+            u32 end = mark->start + mark->size;
+
+            if(start < end)
+            {
+                found = findChanges(history, start, end, &ranges, &count, &capacity);
+                from = end;
+            }
+        }
+
+        history->markCount = 0;
+    }
+    else found = findChanges(history, 0, history->size, &ranges, &count, &capacity);
 
+    if(!count)
     {
-        Data data;
-        data.start = trim_left(history->state, history->size);
-        data.end = trim_right(history->state, history->size);
-        u32 size = data.end - data.start;
-        data.buffer = malloc(size);
+        free(ranges);
+        return false;
+    }
 
-        memcpy(data.buffer, (u8*)history->state + data.start, size);
+    Item* item = calloc(1, sizeof(Item));
+    u32 size = 0;
 
-        history->list = list_insert(history->list, &data);
+    for(u32 i = 0; i < count; i++)
+        size += ranges[i].size;
+
+    if(!found || !item || !(item->buffer = malloc(size)))
+    {
+        // keep the data consistent with the history
+        free(ranges);
+        free(item);
+        memcpy(history->state, history->data, history->size);
+        return false;
     }
 
-    memcpy(history->state, history->data, history->size);
+    item->id = ++Histories.id;
+    item->ranges = ranges;
+    item->count = count;
+    item->size = size;
+
+    {
+        u8* ptr = item->buffer;
+
+        for(const Range *range = ranges, *end = range + count; range != end; ++range)
+        {
+            u8* state = history->state + range->start;
+            const u8* data = (const u8*)history->data + range->start;
+
+            for(u32 i = 0; i < range->size; i++)
+                *ptr++ = state[i] ^ data[i];
+
+            memcpy(state, data, range->size);
+        }
+    }
+
+    list_insert(history, item);
+
+    {
+        Item* old = item;
+        for(s32 i = 0; i < HISTORY_RECENT && old; i++)
+            old = old->prev;
+
+        if(old && old != history->first)
+            packItem(old);
+    }
+
+    fitBudget();
 
     return true;
 }
 
 void history_undo(History* history)
 {
+    revertMarks(history);
+
     if(history->list->prev)
     {
-        history_diff(history, &history->list->data);
+        applyItem(history, history->list);
 
         history->list = history->list->prev;
     }
-
-    memcpy(history->data, history->state, history->size);
 }
 
 void history_redo(History* history)
 {
+    revertMarks(history);
+
     if(history->list->next)
     {
         history->list = history->list->next;
 
-        history_diff(history, &history->list->data);
+        applyItem(history, history->list);
     }
-
-    memcpy(history->data, history->state, history->size);
 }
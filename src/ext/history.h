@@ -26,7 +26,16 @@
 
 typedef struct History History;
 
+// Every step keeps the xor of the changed ranges only, undo and redo touch
+// just those bytes. Older steps are zipped and the oldest steps of all the
+// histories are dropped when they take too much memory together.
+
 History* history_create(void* data, u32 size);
+
+// limits the next history_add to the marked ranges instead of comparing the whole buffer,
+// the changes outside of them aren't added
+void history_mark(History* history, u32 offset, u32 size);
+
 bool history_add(History* history);
 void history_undo(History* history);
 void history_redo(History* history);
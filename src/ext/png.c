@@ -48,49 +48,76 @@ static void pngReadCallback(png_structp png, png_bytep out, png_size_t size)
     stream->pos += size;
 }
 
-png_img png_read(png_buffer buf)
+typedef struct
 {
-    png_img res = { 0 };
+    png_structp png;
+    png_infop info;
+    PngStream stream;
+    s32 width;
+    s32 height;
+} PngReader;
+
+// reads PNG header and sets up transformations to 8bit RGBA rows
+static bool openReader(PngReader* reader, png_buffer buf)
+{
+    if (png_sig_cmp(buf.data, 0, 8) != 0)
+        return false;
 
-    if (png_sig_cmp(buf.data, 0, 8) == 0)
-    {
-        png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-        png_infop info = png_create_info_struct(png);
+    png_structp png = reader->png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+    png_infop info = reader->info = png_create_info_struct(png);
+
+    reader->stream = (PngStream){ .buffer = buf};
+
+    png_set_read_fn(png, &reader->stream, pngReadCallback);
+    png_read_info(png, info);
+
+    reader->width = png_get_image_width(png, info);
+    reader->height = png_get_image_height(png, info);
+    s32 colorType = png_get_color_type(png, info);
+    s32 bitDepth = png_get_bit_depth(png, info);
 
-        PngStream stream = { .buffer = buf};
+    if (bitDepth == 16)
+        png_set_strip_16(png);
 
-        png_set_read_fn(png, &stream, pngReadCallback);
-        png_read_info(png, info);
+    if (colorType == PNG_COLOR_TYPE_PALETTE)
+        png_set_palette_to_rgb(png);
 
-        res.width = png_get_image_width(png, info);
-        res.height = png_get_image_height(png, info);
-        s32 colorType = png_get_color_type(png, info);
-        s32 bitDepth = png_get_bit_depth(png, info);
+    // PNG_COLOR_TYPE_GRAY_ALPHA is always 8 or 16bit depth.
+    if (colorType == PNG_COLOR_TYPE_GRAY && bitDepth < 8)
+        png_set_expand_gray_1_2_4_to_8(png);
 
-        if (bitDepth == 16)
-            png_set_strip_16(png);
+    if (png_get_valid(png, info, PNG_INFO_tRNS))
+        png_set_tRNS_to_alpha(png);
 
-        if (colorType == PNG_COLOR_TYPE_PALETTE)
-            png_set_palette_to_rgb(png);
+    // These colorType don't have an alpha channel then fill it with 0xff.
+    if (colorType == PNG_COLOR_TYPE_RGB ||
+        colorType == PNG_COLOR_TYPE_GRAY ||
+        colorType == PNG_COLOR_TYPE_PALETTE)
+        png_set_filler(png, 0xFF, PNG_FILLER_AFTER);
 
-        // PNG_COLOR_TYPE_GRAY_ALPHA is always 8 or 16bit depth.
-        if (colorType == PNG_COLOR_TYPE_GRAY && bitDepth < 8)
-            png_set_expand_gray_1_2_4_to_8(png);
+    if (colorType == PNG_COLOR_TYPE_GRAY ||
+        colorType == PNG_COLOR_TYPE_GRAY_ALPHA)
+        png_set_gray_to_rgb(png);
 
-        if (png_get_valid(png, info, PNG_INFO_tRNS))
-            png_set_tRNS_to_alpha(png);
+    png_read_update_info(png, info);
 
-        // These colorType don't have an alpha channel then fill it with 0xff.
-        if (colorType == PNG_COLOR_TYPE_RGB ||
-            colorType == PNG_COLOR_TYPE_GRAY ||
-            colorType == PNG_COLOR_TYPE_PALETTE)
-            png_set_filler(png, 0xFF, PNG_FILLER_AFTER);
+    return true;
+}
+
+static void closeReader(PngReader* reader)
+{
+    png_destroy_read_struct(&reader->png, &reader->info, NULL);
+}
 
-        if (colorType == PNG_COLOR_TYPE_GRAY ||
-            colorType == PNG_COLOR_TYPE_GRAY_ALPHA)
-            png_set_gray_to_rgb(png);
+png_img png_read(png_buffer buf)
+{
+    png_img res = { 0 };
+    PngReader reader;
 
-        png_read_update_info(png, info);
+    if (openReader(&reader, buf))
+    {
+        res.width = reader.width;
+        res.height = reader.height;
 
         res.data = malloc(RGBA_SIZE * res.width * res.height);
         png_bytep* rows = (png_bytep*)malloc(sizeof(png_bytep) * res.height);
@@ -98,11 +125,11 @@ png_img png_read(png_buffer buf)
         for (s32 i = 0; i < res.height; i++)
             rows[i] = res.data + res.width * i * RGBA_SIZE;
 
-        png_read_image(png, rows);
+        png_read_image(reader.png, rows);
 
         free(rows);
 
-        png_destroy_read_struct(&png, &info, NULL);
+        closeReader(&reader);
     }
 
     return res;
@@ -174,12 +201,104 @@ static_assert(sizeof(Header) == RGBA_SIZE, "header_size");
 #define HEADER_BITS 4
 #define HEADER_SIZE (sizeof(Header) * BITS_IN_BYTE / HEADER_BITS)
 
-static inline void bitcpy(u8* dst, u32 to, const u8* src, u32 from, u32 size)
+// every cover byte keeps `bits` bits of the cart stream in its low bits,
+// the stream is moved through a 64bit accumulator a word at a time
+typedef struct
+{
+    u8* data;
+    s32 size;
+    s32 pos;
+    u64 acc;
+    s32 count;
+} BitStream;
+
+#define BITS_LIST(macro) macro(1) macro(2) macro(3) macro(4) macro(5) macro(6) macro(7) macro(8)
+
+static inline void packBits(u8* dst, s32 size, BitStream* src, s32 bits)
+{
+    const u8 mask = (1 << bits) - 1;
+
+    for (s32 i = 0; i < size; i++)
+    {
+        if (src->count < bits)
+        {
+            if (src->pos + 4 <= src->size)
+            {
+                const u8* ptr = src->data + src->pos;
+                src->acc |= (u64)(ptr[0] | ptr[1] << 8 | ptr[2] << 16 | (u32)ptr[3] << 24) << src->count;
+                src->pos += 4;
+                src->count += 32;
+            }
+            else
+            {
+                // pad the tail of the stream with zeros
+                src->acc |= (u64)(src->pos < src->size ? src->data[src->pos] : 0) << src->count;
+                src->pos++;
+                src->count += BITS_IN_BYTE;
+            }
+        }
+
+        dst[i] = (dst[i] & ~mask) | (src->acc & mask);
+        src->acc >>= bits;
+        src->count -= bits;
+    }
+}
+
+static inline void unpackBits(BitStream* dst, const u8* src, s32 size, s32 bits)
+{
+    const u8 mask = (1 << bits) - 1;
+
+    for (s32 i = 0; i < size; i++)
+    {
+        dst->acc |= (u64)(src[i] & mask) << dst->count;
+        dst->count += bits;
+
+        if (dst->count >= 32)
+        {
+            if (dst->pos + 4 <= dst->size)
+            {
+                u8* ptr = dst->data + dst->pos;
+                ptr[0] = dst->acc;
+                ptr[1] = dst->acc >> 8;
+                ptr[2] = dst->acc >> 16;
+                ptr[3] = dst->acc >> 24;
+                dst->pos += 4;
+            }
+            else
+                for (s32 b = 0; b < 4 && dst->pos < dst->size; b++)
+                    dst->data[dst->pos++] = dst->acc >> (b * BITS_IN_BYTE);
+
+            dst->acc >>= 32;
+            dst->count -= 32;
+        }
+    }
+}
+
+static void flushBits(BitStream* dst)
+{
+    for (; dst->count > 0 && dst->pos < dst->size; dst->count -= BITS_IN_BYTE, dst->acc >>= BITS_IN_BYTE)
+        dst->data[dst->pos++] = dst->acc;
+}
+
+// dispatch to the variants specialized for constant bit counts
+static void pack(u8* dst, s32 size, BitStream* src, s32 bits)
 {
-    for(s32 i = 0; i < size; i++, to++, from++)
-        BITCHECK(src[from >> 3], from & 7) 
-            ? _BITSET(dst[to >> 3], to & 7) 
-            : _BITCLEAR(dst[to >> 3], to & 7);
+    switch (bits)
+    {
+#define BITS_CASE(N) case N: packBits(dst, size, src, N); break;
+        BITS_LIST(BITS_CASE)
+#undef BITS_CASE
+    }
+}
+
+static void unpack(BitStream* dst, const u8* src, s32 size, s32 bits)
+{
+    switch (bits)
+    {
+#define BITS_CASE(N) case N: unpackBits(dst, src, size, N); break;
+        BITS_LIST(BITS_CASE)
+#undef BITS_CASE
+    }
 }
 
 static inline s32 ceildiv(s32 a, s32 b)
@@ -195,16 +314,24 @@ png_buffer png_encode(png_buffer cover, png_buffer cart)
     const s32 coverSize = png.width * png.height * RGBA_SIZE - HEADER_SIZE;
     Header header = {CLAMP(ceildiv(cartBits, coverSize), 1, BITS_IN_BYTE), cart.size};
 
-    for (s32 i = 0; i < HEADER_SIZE; i++)
-        bitcpy(png.data, i << 3, header.data, i * HEADER_BITS, HEADER_BITS);
+    pack(png.data, HEADER_SIZE, &(BitStream){header.data, sizeof header}, HEADER_BITS);
 
     u8* dst = png.data + HEADER_SIZE;
-    s32 end = ceildiv(cartBits, header.bits);
-    for (s32 i = 0; i < end; i++)
-        bitcpy(dst, i << 3, cart.data, i * header.bits, header.bits);
+    s32 end = MIN(ceildiv(cartBits, header.bits), coverSize);
+    pack(dst, end, &(BitStream){cart.data, cart.size}, header.bits);
+
+    {
+        const u8 mask = (1 << header.bits) - 1;
+        u32 seed = rand() | 1;
 
-    for (s32 i = end; i < coverSize; i++)
-        bitcpy(dst, i << 3, (const u8[]){rand()}, 0, header.bits);
+        for (s32 i = end; i < coverSize; i++)
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            dst[i] = (dst[i] & ~mask) | (seed & mask);
+        }
+    }
 
     png_buffer out = png_write(png);
 
@@ -213,34 +340,87 @@ png_buffer png_encode(png_buffer cover, png_buffer cart)
     return out;
 }
 
+// decodes rows one by one and stops as soon as the whole cart is read
 png_buffer png_decode(png_buffer cover)
 {
-    png_img png = png_read(cover);
+    png_buffer out = { 0 };
+    PngReader reader;
 
-    if (png.data)
+    if (openReader(&reader, cover))
     {
-        Header header;
+        // interlaced images can't be read row by row, take them as one big row
+        const bool interlaced = png_get_interlace_type(reader.png, reader.info) != PNG_INTERLACE_NONE;
+        const s32 rows = interlaced ? 1 : reader.height;
+        const s32 rowSize = reader.width * RGBA_SIZE * (interlaced ? reader.height : 1);
+        u8* row = malloc(rowSize);
 
-        for (s32 i = 0; i < HEADER_SIZE; i++)
-            bitcpy(header.data, i * HEADER_BITS, png.data, i << 3, HEADER_BITS);
+        Header header;
+        BitStream headerStream = {header.data, sizeof header};
+        BitStream cartStream = { 0 };
+        s32 read = 0, end = 0;
 
-        if (header.bits > 0 
-            && header.bits <= BITS_IN_BYTE 
-            && header.size > 0 
-            && header.size <= png.width * png.height * RGBA_SIZE * header.bits / BITS_IN_BYTE - HEADER_SIZE)
+        for (s32 y = 0; y < rows; y++)
         {
-            s32 aligned = header.size + ceildiv(header.size * BITS_IN_BYTE % header.bits, BITS_IN_BYTE);
-            png_buffer out = { malloc(aligned), header.size };
-
-            const u8* from = png.data + HEADER_SIZE;
-            for (s32 i = 0, end = ceildiv(header.size * BITS_IN_BYTE, header.bits); i < end; i++)
-                bitcpy(out.data, i * header.bits, from, i << 3, header.bits);
-
-            free(png.data);
+            if (interlaced)
+            {
+                png_bytep* ptrs = (png_bytep*)malloc(sizeof(png_bytep) * reader.height);
+
+                for (s32 i = 0; i < reader.height; i++)
+                    ptrs[i] = row + reader.width * i * RGBA_SIZE;
+
+                png_read_image(reader.png, ptrs);
+                free(ptrs);
+            }
+            else png_read_row(reader.png, row, NULL);
+
+            const u8* ptr = row;
+            s32 left = rowSize;
+
+            if (read < HEADER_SIZE)
+            {
+                s32 size = MIN(left, HEADER_SIZE - read);
+                unpack(&headerStream, ptr, size, HEADER_BITS);
+                ptr += size;
+                left -= size;
+                read += size;
+
+                if (read < HEADER_SIZE)
+                    continue;
+
+                flushBits(&headerStream);
+
+                if (header.bits > 0 
+                    && header.bits <= BITS_IN_BYTE 
+                    && header.size > 0 
+                    && header.size * BITS_IN_BYTE <= (reader.width * reader.height * RGBA_SIZE - HEADER_SIZE) * header.bits)
+                {
+                    out = (png_buffer){ malloc(header.size), header.size };
+                    cartStream = (BitStream){ out.data, out.size };
+                    end = HEADER_SIZE + ceildiv(header.size * BITS_IN_BYTE, header.bits);
+                }
+                else break;
+            }
+
+            s32 size = MIN(left, end - read);
+            unpack(&cartStream, ptr, size, header.bits);
+            read += size;
+
+            if (read == end)
+            {
+                flushBits(&cartStream);
+                break;
+            }
+        }
 
-            return out;
+        if (read < end)
+        {
+            free(out.data);
+            out = (png_buffer){ 0 };
         }
+
+        free(row);
+        closeReader(&reader);
     }
 
-    return (png_buffer) { 0 };
+    return out;
 }
@@ -0,0 +1,402 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "covers.h"
+#include "studio.h"
+#include "fs.h"
+#include "cart.h"
+#include "ext/png.h"
+
+#if defined(TIC80_PRO)
+#include "project.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#if defined(USE_LIBUV)
+#include <uv.h>
+#endif
+
+static const char CoverExt[] = ".cover";
+
+// a cached cover takes ~16K, so it's about a thousand of the latest ones
+#define COVERS_CACHE_SIZE (16 * 1024 * 1024)
+
+typedef struct
+{
+    char* path;
+    s32 id;
+} Request;
+
+// cached cover, carts without cover are cached as a single zero byte
+typedef struct
+{
+    tic_screen screen;
+    tic_palette palette;
+} CachedCover;
+
+struct tic_covers
+{
+    char* cache;
+
+    // the last request is served first
+    Request* requests;
+    s32 count;
+    s32 capacity;
+
+    tic_cover** loaded;
+    s32 loadedCount;
+    s32 loadedCapacity;
+
+    // id of the cover being loaded or -1
+    s32 loading;
+
+    // results of the requests made before tic_covers_clear are dropped
+    u32 generation;
+
+    // unpacked png cart
+    u8* buffer;
+
+#if defined(TIC80_PRO)
+    tic_cartridge* cart;
+#endif
+
+#if defined(USE_LIBUV)
+    uv_thread_t thread;
+    uv_mutex_t mutex;
+    uv_cond_t cond;
+
+    bool threaded;
+    bool done;
+#endif
+};
+
+static inline void lock(tic_covers* covers)
+{
+#if defined(USE_LIBUV)
+    if(covers->threaded)
+        uv_mutex_lock(&covers->mutex);
+#endif
+}
+
+static inline void unlock(tic_covers* covers)
+{
+#if defined(USE_LIBUV)
+    if(covers->threaded)
+    {
+        uv_cond_broadcast(&covers->cond);
+        uv_mutex_unlock(&covers->mutex);
+    }
+#endif
+}
+
+static u64 fnv1a(u64 hash, const void* data, s32 size)
+{
+    for(const u8 *ptr = data, *end = ptr + size; ptr != end; ptr++)
+        hash = (hash ^ *ptr) * 0x100000001b3ull;
+
+    return hash;
+}
+
+static char* cachePath(tic_covers* covers, const char* path, u64 date, s32 size)
+{
+    u64 key = fnv1a(0xcbf29ce484222325ull, path, (s32)strlen(path));
+    key = fnv1a(key, &date, sizeof date);
+    key = fnv1a(key, &size, sizeof size);
+
+    char* name = malloc(strlen(covers->cache) + sizeof "0123456789abcdef" + sizeof CoverExt);
+    sprintf(name, "%s%016llx%s", covers->cache, (unsigned long long)key, CoverExt);
+
+    return name;
+}
+
+static bool readCover(tic_covers* covers, const char* path, const fs_view* view, tic_cover* cover)
+{
+    if(tic_tool_has_ext(path, PNG_EXT))
+    {
+        bool found = false;
+        png_buffer zip = png_decode((png_buffer){(u8*)view->data, view->size});
+
+        if(zip.size)
+        {
+            if(!covers->buffer)
+                covers->buffer = malloc(sizeof(tic_cartridge));
+
+            s32 size = tic_tool_unzip(covers->buffer, sizeof(tic_cartridge), zip.data, zip.size);
+            found = size && tic_cart_cover(covers->buffer, size, &cover->screen, &cover->palette);
+
+            free(zip.data);
+        }
+
+        return found;
+    }
+
+#if defined(TIC80_PRO)
+    if(tic_project_ext(path))
+    {
+        if(!covers->cart)
+            covers->cart = calloc(1, sizeof(tic_cartridge));
+
+        // a failed load leaves the previous project in the buffer
+        if(!tic_project_load(path, (const char*)view->data, view->size, covers->cart))
+            return false;
+
+        memcpy(&cover->screen, &covers->cart->bank0.screen, sizeof(tic_screen));
+        memcpy(&cover->palette, &covers->cart->bank0.palette.vbank0, sizeof(tic_palette));
+
+        return !EMPTY(cover->screen.data) && !EMPTY(cover->palette.data);
+    }
+#endif
+
+    return tic_cart_cover(view->data, view->size, &cover->screen, &cover->palette);
+}
+
+static tic_cover* loadCover(tic_covers* covers, Request* request)
+{
+    tic_cover* cover = calloc(1, sizeof(tic_cover));
+    cover->id = request->id;
+
+    fs_view view;
+
+    if(fs_view_open(request->path, &view))
+    {
+        char* cached = cachePath(covers, request->path, fs_date(request->path), view.size);
+
+        s32 size = 0;
+        CachedCover* data = fs_read(cached, &size);
+
+        if(data && size == sizeof(CachedCover))
+        {
+            cover->found = true;
+            memcpy(&cover->screen, &data->screen, sizeof(tic_screen));
+            memcpy(&cover->palette, &data->palette, sizeof(tic_palette));
+        }
+        else if(!(data && size == 1))
+        {
+            static const u8 NoCover = 0;
+
+            if((cover->found = readCover(covers, request->path, &view, cover)))
+            {
+                CachedCover cache;
+                memcpy(&cache.screen, &cover->screen, sizeof(tic_screen));
+                memcpy(&cache.palette, &cover->palette, sizeof(tic_palette));
+                fs_replace(cached, &cache, sizeof cache);
+            }
+            else fs_replace(cached, &NoCover, sizeof NoCover);
+        }
+
+        free(data);
+        free(cached);
+        fs_view_close(&view);
+    }
+
+    free(request->path);
+
+    return cover;
+}
+
+static void addLoaded(tic_covers* covers, tic_cover* cover)
+{
+    if(covers->loadedCount == covers->loadedCapacity)
+    {
+        covers->loadedCapacity = covers->loadedCapacity ? covers->loadedCapacity * 2 : 8;
+        covers->loaded = realloc(covers->loaded, covers->loadedCapacity * sizeof(tic_cover*));
+    }
+
+    covers->loaded[covers->loadedCount++] = cover;
+}
+
+#if defined(USE_LIBUV)
+
+static void loadCovers(void* arg)
+{
+    tic_covers* covers = arg;
+
+    fs_trim(covers->cache, CoverExt, COVERS_CACHE_SIZE);
+
+    uv_mutex_lock(&covers->mutex);
+
+    while(!covers->done)
+    {
+        if(covers->count == 0)
+        {
+            uv_cond_wait(&covers->cond, &covers->mutex);
+            continue;
+        }
+
+        Request request = covers->requests[--covers->count];
+        u32 generation = covers->generation;
+        covers->loading = request.id;
+
+        uv_mutex_unlock(&covers->mutex);
+        tic_cover* cover = loadCover(covers, &request);
+        uv_mutex_lock(&covers->mutex);
+
+        if(generation == covers->generation)
+        {
+            covers->loading = -1;
+            addLoaded(covers, cover);
+        }
+        else free(cover);
+    }
+
+    uv_mutex_unlock(&covers->mutex);
+}
+
+#endif
+
+tic_covers* tic_covers_create(const char* cache)
+{
+    tic_covers* covers = calloc(1, sizeof(tic_covers));
+
+    covers->cache = strdup(cache);
+    covers->loading = -1;
+
+#if defined(USE_LIBUV)
+    uv_mutex_init(&covers->mutex);
+    uv_cond_init(&covers->cond);
+
+    covers->threaded = uv_thread_create(&covers->thread, loadCovers, covers) == 0;
+
+    if(!covers->threaded)
+#endif
+        fs_trim(covers->cache, CoverExt, COVERS_CACHE_SIZE);
+
+    return covers;
+}
+
+void tic_covers_load(tic_covers* covers, const char* path, s32 id)
+{
+    lock(covers);
+
+    if(covers->loading != id)
+    {
+        Request request = {NULL, id};
+
+        for(s32 i = 0; i < covers->count; i++)
+            if(covers->requests[i].id == id)
+            {
+                // move the queued request to the top
+                request = covers->requests[i];
+                memmove(covers->requests + i, covers->requests + i + 1, (covers->count - i - 1) * sizeof(Request));
+                covers->count--;
+                break;
+            }
+
+        if(!request.path)
+        {
+            request.path = strdup(path);
+
+            if(covers->count == covers->capacity)
+            {
+                covers->capacity = covers->capacity ? covers->capacity * 2 : 16;
+                covers->requests = realloc(covers->requests, covers->capacity * sizeof(Request));
+            }
+        }
+
+        covers->requests[covers->count++] = request;
+    }
+
+    unlock(covers);
+}
+
+void tic_covers_update(tic_covers* covers)
+{
+#if defined(USE_LIBUV)
+    if(covers->threaded)
+        return;
+#endif
+
+    // one cover per update to keep the frame time
+    if(covers->count)
+    {
+        Request request = covers->requests[--covers->count];
+        addLoaded(covers, loadCover(covers, &request));
+    }
+}
+
+tic_cover* tic_covers_done(tic_covers* covers)
+{
+    tic_cover* cover = NULL;
+
+    lock(covers);
+
+    if(covers->loadedCount)
+        cover = covers->loaded[--covers->loadedCount];
+
+    unlock(covers);
+
+    return cover;
+}
+
+void tic_covers_clear(tic_covers* covers)
+{
+    lock(covers);
+
+    for(s32 i = 0; i < covers->count; i++)
+        free(covers->requests[i].path);
+
+    for(s32 i = 0; i < covers->loadedCount; i++)
+        free(covers->loaded[i]);
+
+    covers->count = covers->loadedCount = 0;
+    covers->loading = -1;
+    covers->generation++;
+
+    unlock(covers);
+}
+
+void tic_covers_delete(tic_covers* covers)
+{
+    tic_covers_clear(covers);
+
+#if defined(USE_LIBUV)
+    if(covers->threaded)
+    {
+        uv_mutex_lock(&covers->mutex);
+        covers->done = true;
+        uv_cond_broadcast(&covers->cond);
+        uv_mutex_unlock(&covers->mutex);
+
+        uv_thread_join(&covers->thread);
+    }
+
+    uv_cond_destroy(&covers->cond);
+    uv_mutex_destroy(&covers->mutex);
+#endif
+
+    for(s32 i = 0; i < covers->loadedCount; i++)
+        free(covers->loaded[i]);
+
+    free(covers->loaded);
+    free(covers->requests);
+    free(covers->buffer);
+
+#if defined(TIC80_PRO)
+    free(covers->cart);
+#endif
+
+    free(covers->cache);
+    free(covers);
+}
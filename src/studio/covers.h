@@ -0,0 +1,48 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "tic.h"
+
+// Background loader of cart covers for the Surf mode. Only the screen and
+// palette are read from the cart and the result is cached in the `cache`
+// folder under a key of the cart path, modification date and size.
+// The latest requested cover is loaded first (covers are loaded on the
+// caller thread from tic_covers_update when threads aren't available).
+
+typedef struct tic_covers tic_covers;
+
+typedef struct
+{
+    s32 id;
+    bool found;
+    tic_screen screen;
+    tic_palette palette;
+} tic_cover;
+
+tic_covers* tic_covers_create   (const char* cache);
+void        tic_covers_load     (tic_covers* covers, const char* path, s32 id);
+void        tic_covers_update   (tic_covers* covers);
+tic_cover*  tic_covers_done     (tic_covers* covers);
+void        tic_covers_clear    (tic_covers* covers);
+void        tic_covers_delete   (tic_covers* covers);
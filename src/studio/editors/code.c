@@ -33,6 +33,7 @@
 #define CODE_EDITOR_HEIGHT (TIC80_HEIGHT - TOOLBAR_SIZE - STUDIO_TEXT_HEIGHT)
 #define TEXT_BUFFER_HEIGHT (CODE_EDITOR_HEIGHT / STUDIO_TEXT_HEIGHT)
 #define OUTLINE_WIDTH (13 * TIC_FONT_WIDTH)
+#define SYNTAX_END TIC_CODE_SIZE
 
 #if defined(TIC80_PRO)
 #   define MAX_CODE sizeof(tic_code)
@@ -51,32 +52,64 @@ enum
 #undef  CODE_COLOR_DEF
 };
 
+// lexer states a line can be opened in, kept in the `temp` bits of its first char
+enum
+{
+    LexState_Code,
+    LexState_BlockComment,
+    LexState_BlockComment2,
+    LexState_BlockString,
+    LexState_Quote,
+    LexState_DoubleQuote,
+};
+
+// the text is packed from the first change, the rest of the state already has it
 static void packState(Code* code)
 {
-    const char* src = code->src;
-    for(CodeState* s = code->state, *end = s + TIC_CODE_SIZE; s != end; ++s)
+    code->packed = MAX(code->packed, (s32)strlen(code->src) + 1);
+
+    const char* src = code->src + code->step.changed;
+    for(CodeState* s = code->state + code->step.changed, *end = code->state + code->packed; s < end; ++s)
     {
-        s->cursor = src == code->cursor.position;
+        s->cursor = false;
         s->sym = *src++;
     }
+
+    code->state[code->step.cursor].cursor = false;
+    code->step.cursor = (s32)(code->cursor.position - code->src);
+    code->state[code->step.cursor].cursor = true;
 }
 
 static void unpackState(Code* code)
 {
     char* src = code->src;
-    for(CodeState* s = code->state, *end = s + TIC_CODE_SIZE; s != end; ++s)
+    for(CodeState* s = code->state, *end = s + code->packed; s != end; ++s)
     {
         if(s->cursor)
             code->cursor.position = src;
 
         *src++ = s->sym;
     }
+
+    code->step.cursor = (s32)(code->cursor.position - code->src);
 }
 
+// marks the shifted text and the old and new cursor, the rest isn't compared
 static void history(Code* code)
 {
+    s32 changed = code->step.changed;
+    s32 cursor = code->step.cursor;
+
     packState(code);
+
+    if(changed < code->packed)
+        history_mark(code->history, changed * sizeof(CodeState), (code->packed - changed) * sizeof(CodeState));
+
+    history_mark(code->history, cursor * sizeof(CodeState), sizeof(CodeState));
+    history_mark(code->history, code->step.cursor * sizeof(CodeState), sizeof(CodeState));
     history_add(code->history);
+
+    code->step.changed = TIC_CODE_SIZE;
 }
 
 static void drawStatus(Code* code)
@@ -89,16 +122,91 @@ static void drawStatus(Code* code)
         StatusY, getConfig(code->studio)->theme.code.BG, true, 1, false);
 }
 
-static char* getPosByLine(char* ptr, s32 line)
+static s32 getLineIndex(Code* code, const char* pos)
 {
-    s32 y = 0;
-    while(*ptr)
+    // the last line starting at or before the position
+    s32 offset = (s32)(pos - code->src);
+    s32 first = 0, last = code->lines.count;
+
+    while(first < last)
     {
-        if(y == line) break;
-        if(*ptr++ == '\n') y++;
+        s32 middle = (first + last) / 2;
+
+        if(code->lines.starts[middle] <= offset)
+            first = middle + 1;
+        else last = middle;
     }
 
-    return ptr;    
+    return first - 1;
+}
+
+static char* getPosByLine(Code* code, s32 line)
+{
+    return line >= 0 && line < code->lines.count
+        ? code->src + code->lines.starts[line]
+        : code->src + strlen(code->src);
+}
+
+static void reserveLines(Code* code, s32 count)
+{
+    if(count > code->lines.capacity)
+    {
+        code->lines.capacity = MAX(count, code->lines.capacity * 2);
+        code->lines.starts = realloc(code->lines.starts, code->lines.capacity * sizeof(s32));
+    }
+}
+
+static void indexLines(Code* code)
+{
+    s32 count = 1;
+    for(const char* ptr = code->src; *ptr; ptr++)
+        if(*ptr == '\n')
+            count++;
+
+    reserveLines(code, count);
+
+    s32* starts = code->lines.starts;
+    *starts++ = 0;
+
+    for(const char* ptr = code->src; *ptr; ptr++)
+        if(*ptr == '\n')
+            *starts++ = (s32)(ptr + 1 - code->src);
+
+    code->lines.count = count;
+}
+
+// keeps the line starts in sync with `removed` chars at `pos` replaced by `inserted` ones
+static void reindexLines(Code* code, const char* pos, s32 removed, s32 inserted)
+{
+    s32 offset = (s32)(pos - code->src);
+    s32 count = code->lines.count;
+
+    // lines starting within the removed text are gone
+    s32 first = getLineIndex(code, pos) + 1;
+    s32 last = first;
+
+    while(last < count && code->lines.starts[last] <= offset + removed)
+        last++;
+
+    s32 added = 0;
+    for(const char* ptr = pos, *end = pos + inserted; ptr != end; ptr++)
+        if(*ptr == '\n')
+            added++;
+
+    reserveLines(code, count - (last - first) + added);
+
+    s32* starts = code->lines.starts;
+    memmove(starts + first + added, starts + last, (count - last) * sizeof(s32));
+    count += added - (last - first);
+
+    for(s32* start = starts + first + added, *end = starts + count; start != end; ++start)
+        *start += inserted - removed;
+
+    for(const char* ptr = pos, *end = pos + inserted; ptr != end; ptr++)
+        if(*ptr == '\n')
+            starts[first++] = (s32)(ptr + 1 - code->src);
+
+    code->lines.count = count;
 }
 
 static char* getNextLineByPos(Code* code, char* pos)
@@ -131,6 +239,8 @@ static void toggleBookmark(Code* code, char* codePos)
     }
     else start->bookmark = 1;
 
+    // the text is untouched, so the line cells are marked for the history here
+    history_mark(code->history, (u32)((start - code->state) * sizeof(CodeState)), (u32)(MAX(end - start, 1) * sizeof(CodeState)));
     history(code);
 }
 
@@ -154,22 +264,28 @@ static void drawBookmarks(Code* code)
         drawBitIcon(code->studio, tic_icon_bookmark, rect.x, rect.y + line * STUDIO_TEXT_HEIGHT - 1, tic_color_dark_grey);
 
         if(checkMouseClick(code->studio, &rect, tic_mouse_left))
-            toggleBookmark(code, getPosByLine(code->src, line + code->scroll.y));
+            toggleBookmark(code, getPosByLine(code, line + code->scroll.y));
     }
 
-    const char* pointer = code->src;
-    const CodeState* syntaxPointer = code->state;
-    s32 y = -code->scroll.y;
+    s32 first = MAX(code->scroll.y, 0);
+    s32 last = MIN(code->scroll.y + TEXT_BUFFER_HEIGHT + 1, code->lines.count);
 
-    while(*pointer)
+    for(s32 i = first; i < last; i++)
     {
-        if(syntaxPointer++->bookmark)
+        const char* pointer = getPosByLine(code, i);
+        const CodeState* syntaxPointer = getState(code, pointer);
+        s32 y = i - code->scroll.y;
+
+        while(*pointer)
         {
-            drawBitIcon(code->studio, tic_icon_bookmark, rect.x, rect.y + y * STUDIO_TEXT_HEIGHT, tic_color_black);
-            drawBitIcon(code->studio, tic_icon_bookmark, rect.x, rect.y + y * STUDIO_TEXT_HEIGHT - 1, tic_color_yellow);
-        }
+            if(syntaxPointer++->bookmark)
+            {
+                drawBitIcon(code->studio, tic_icon_bookmark, rect.x, rect.y + y * STUDIO_TEXT_HEIGHT, tic_color_black);
+                drawBitIcon(code->studio, tic_icon_bookmark, rect.x, rect.y + y * STUDIO_TEXT_HEIGHT - 1, tic_color_yellow);
+            }
 
-        if(*pointer++ == '\n')y++;
+            if(*pointer++ == '\n') break;
+        }
     }
 }
 
@@ -206,19 +322,26 @@ static void drawMatchedDelim(Code* code, s32 x, s32 y, char symbol, u8 color)
     drawChar(code->tic, symbol, x, y, color, code->altFont);
 }
 
+static void parseSyntaxColor(Code* code);
+
 static void drawCode(Code* code, bool withCursor)
 {
     tic_rect rect = {BOOKMARK_WIDTH, TOOLBAR_SIZE, CODE_EDITOR_WIDTH, CODE_EDITOR_HEIGHT};
 
+    parseSyntaxColor(code);
+
+    // start from the line partially visible above the top
+    s32 line = MIN(MAX(code->scroll.y - 1, 0), code->lines.count - 1);
+
     s32 xStart = rect.x - code->scroll.x * getFontWidth(code);
     s32 x = xStart;
-    s32 y = rect.y - code->scroll.y * STUDIO_TEXT_HEIGHT;
-    const char* pointer = code->src;
+    s32 y = rect.y + (line - code->scroll.y) * STUDIO_TEXT_HEIGHT;
+    const char* pointer = getPosByLine(code, line);
 
     u8 selectColor = getConfig(code->studio)->theme.code.select;
 
     const u8* colors = (const u8*)&getConfig(code->studio)->theme.code;
-    const CodeState* syntaxPointer = code->state;
+    const CodeState* syntaxPointer = getState(code, pointer);
 
     struct { char* start; char* end; } selection = 
     {
@@ -229,7 +352,7 @@ static void drawCode(Code* code, bool withCursor)
     struct { s32 x; s32 y; char symbol; } cursor = {-1, -1, 0};
     struct { s32 x; s32 y; char symbol; u8 color; } matchedDelim = {-1, -1, 0, 0};
 
-    while(*pointer)
+    while(*pointer && y < TIC80_HEIGHT)
     {
         char symbol = *pointer;
 
@@ -288,36 +411,13 @@ static void drawCode(Code* code, bool withCursor)
 
 static void getCursorPosition(Code* code, s32* x, s32* y)
 {
-    *x = 0;
-    *y = 0;
-
-    const char* pointer = code->src;
-
-    while(*pointer)
-    {
-        if(code->cursor.position == pointer) return;
-
-        if(*pointer == '\n')
-        {
-            *x = 0;
-            (*y)++;
-        }
-        else (*x)++;
-
-        pointer++;
-    }
+    *y = getLineIndex(code, code->cursor.position);
+    *x = (s32)(code->cursor.position - getPosByLine(code, *y));
 }
 
 static s32 getLinesCount(Code* code)
 {
-    char* text = code->src;
-    s32 count = 0;
-
-    while(*text)
-        if(*text++ == '\n')
-            count++;
-
-    return count;
+    return code->lines.count - 1;
 }
 
 static void removeInvalidChars(char* code)
@@ -327,12 +427,23 @@ static void removeInvalidChars(char* code)
     for(s = d = code; (*d = *s); d += (*s++ != '\r'));
 }
 
+static void parseSyntax(Code* code, const char* until);
+
+// the text is lexed lazily, so the highlighting is brought up to the char first
+static bool inCommentOrString(Code* code, const char* pos)
+{
+    if(pos - code->src >= code->syntax.valid)
+        parseSyntax(code, getNextLineByPos(code, (char*)pos));
+
+    u8 syntax = getState(code, pos)->syntax;
+    return syntax == SyntaxType_COMMENT || syntax == SyntaxType_STRING;
+}
+
 const char* findMatchedDelim(Code* code, const char* current)
 {
     const char* start = code->src;
     // delimiters inside comments and strings don't get to be matched!
-    if(code->state[current - start].syntax == SyntaxType_COMMENT ||
-       code->state[current - start].syntax == SyntaxType_STRING) return 0;
+    if(inCommentOrString(code, current)) return 0;
 
     char initial = *current;
     char seeking = 0;
@@ -352,8 +463,7 @@ const char* findMatchedDelim(Code* code, const char* current)
     {
         current += dir;
         // skip over anything inside a comment or string
-        if(code->state[current - start].syntax == SyntaxType_COMMENT ||
-           code->state[current - start].syntax == SyntaxType_STRING) continue;
+        if(inCommentOrString(code, current)) continue;
         if(*current == seeking) return current;
         if(*current == initial) current = findMatchedDelim(code, current);
         if(!current) break;
@@ -400,18 +510,39 @@ static void setCodeState(CodeState* state, u8 color, s32 start, s32 size)
         s->syntax = color;
 }
 
-static void parseCode(const tic_script_config* config, const char* start, CodeState* state)
+static const char* findInLine(const char* ptr, const char* token)
+{
+    for(size_t size = strlen(token); !islineend(*ptr); ptr++)
+        if(strncmp(ptr, token, size) == 0)
+            return ptr;
+
+    return NULL;
+}
+
+// lexes the line at `*line` opened in the `lex` state,
+// moves `*line` to the next one and returns the state the next line is opened in
+static u8 parseLine(const tic_script_config* config, const char* start, CodeState* state, const char** line, u8 lex)
 {
-    const char* ptr = start;
+    const char* ptr = *line;
+    const char* next = ptr;
+
+    while(!islineend(*next)) next++;
+    if(*next) next++;
+
+    *line = next;
 
-    const char* blockCommentStart = NULL;
-    const char* blockCommentStart2 = NULL;
-    const char* blockStringStart = NULL;
-    const char* blockStdStringStart = NULL;
+    setCodeState(state, SyntaxType_FG, (s32)(ptr - start), (s32)(next - ptr));
+
+    const char* blockCommentStart = lex == LexState_BlockComment ? ptr : NULL;
+    const char* blockCommentStart2 = lex == LexState_BlockComment2 ? ptr : NULL;
+    const char* blockStringStart = lex == LexState_BlockString ? ptr : NULL;
+    const char* blockStdStringStart = lex == LexState_Quote || lex == LexState_DoubleQuote ? ptr : NULL;
     const char* singleCommentStart = NULL;
     const char* wordStart = NULL;
     const char* numberStart = NULL;
 
+    char quote = lex == LexState_Quote ? '\'' : '"';
+
 start:
     while(true)
     {
@@ -419,9 +550,15 @@ start:
 
         if(blockCommentStart)
         {
-            const char* end = strstr(ptr, config->blockCommentEnd);
+            const char* end = findInLine(ptr, config->blockCommentEnd);
 
-            ptr = end ? end + strlen(config->blockCommentEnd) : blockCommentStart + strlen(blockCommentStart);
+            if(!end)
+            {
+                setCodeState(state, SyntaxType_COMMENT, (s32)(blockCommentStart - start), (s32)(next - blockCommentStart));
+                return LexState_BlockComment;
+            }
+
+            ptr = end + strlen(config->blockCommentEnd);
             setCodeState(state, SyntaxType_COMMENT, (s32)(blockCommentStart - start), (s32)(ptr - blockCommentStart));
             blockCommentStart = NULL;
 
@@ -430,46 +567,52 @@ start:
         }
         else if(blockCommentStart2)
         {
-            const char* end = strstr(ptr, config->blockCommentEnd2);
+            const char* end = findInLine(ptr, config->blockCommentEnd2);
 
-            ptr = end ? end + strlen(config->blockCommentEnd2) : blockCommentStart2 + strlen(blockCommentStart2);
+            if(!end)
+            {
+                setCodeState(state, SyntaxType_COMMENT, (s32)(blockCommentStart2 - start), (s32)(next - blockCommentStart2));
+                return LexState_BlockComment2;
+            }
+
+            ptr = end + strlen(config->blockCommentEnd2);
             setCodeState(state, SyntaxType_COMMENT, (s32)(blockCommentStart2 - start), (s32)(ptr - blockCommentStart2));
             blockCommentStart2 = NULL;
             goto start;
         }
         else if(blockStringStart)
         {
-            const char* end = strstr(ptr, config->blockStringEnd);
+            const char* end = findInLine(ptr, config->blockStringEnd);
 
-            ptr = end ? end + strlen(config->blockStringEnd) : blockStringStart + strlen(blockStringStart);
+            if(!end)
+            {
+                setCodeState(state, SyntaxType_STRING, (s32)(blockStringStart - start), (s32)(next - blockStringStart));
+                return LexState_BlockString;
+            }
+
+            ptr = end + strlen(config->blockStringEnd);
             setCodeState(state, SyntaxType_STRING, (s32)(blockStringStart - start), (s32)(ptr - blockStringStart));
             blockStringStart = NULL;
             continue;
         }
         else if(blockStdStringStart)
         {
-            const char* blockStart = blockStdStringStart+1;
+            const char* end = NULL;
 
-            while(true)
-            {
-                const char* pos = strchr(blockStart, *blockStdStringStart);
-                
-                if(pos)
-                {
-                    if(*(pos-1) == '\\' && *(pos-2) != '\\') blockStart = pos + 1;
-                    else
-                    {
-                        ptr = pos + 1;
-                        break;
-                    }
-                }
-                else
+            for(const char* pos = ptr; !islineend(*pos); pos++)
+                if(*pos == quote && !(*(pos-1) == '\\' && *(pos-2) != '\\'))
                 {
-                    ptr = blockStdStringStart + strlen(blockStdStringStart);
+                    end = pos;
                     break;
                 }
+
+            if(!end)
+            {
+                setCodeState(state, SyntaxType_STRING, (s32)(blockStdStringStart - start), (s32)(next - blockStdStringStart));
+                return quote == '\'' ? LexState_Quote : LexState_DoubleQuote;
             }
 
+            ptr = end + 1;
             setCodeState(state, SyntaxType_STRING, (s32)(blockStdStringStart - start), (s32)(ptr - blockStdStringStart));
             blockStdStringStart = NULL;
             continue;
@@ -550,6 +693,8 @@ start:
         }
         else
         {
+            if(islineend(c)) break;
+
             if(config->blockCommentStart && memcmp(ptr, config->blockCommentStart, strlen(config->blockCommentStart)) == 0)
             {
                 blockCommentStart = ptr;
@@ -571,6 +716,7 @@ start:
             else if(c == '"' || c == '\'')
             {
                 blockStdStringStart = ptr;
+                quote = c;
                 ptr++;
                 continue;
             }
@@ -595,34 +741,104 @@ start:
             else if(ispunct(c)) state[ptr - start].syntax = SyntaxType_SIGN;
         }
 
-        if(!c) break;
-
         ptr++;
     }
+
+    return LexState_Code;
 }
 
-static void parseSyntaxColor(Code* code)
+static void resetSyntax(Code* code)
 {
-    for(CodeState* s = code->state, *end = s + TIC_CODE_SIZE; s != end; ++s)
-        s->syntax = SyntaxType_FG;
+    code->syntax.valid = 0;
+    code->syntax.lex = LexState_Code;
+    code->syntax.stable = SYNTAX_END;
+}
 
-    tic_mem* tic = code->tic;
+// highlights the text up to the line at `until`, the rest is left for later
+static void parseSyntax(Code* code, const char* until)
+{
+    const tic_script_config* config = tic_core_script_config(code->tic);
 
-    const tic_script_config* config = tic_core_script_config(tic);
+    if(config != code->syntax.config)
+    {
+        code->syntax.config = config;
+        resetSyntax(code);
+    }
+
+    if(code->syntax.valid == SYNTAX_END)
+        return;
+
+    const char* line = code->src + code->syntax.valid;
+    u8 lex = code->syntax.lex;
+
+    while(true)
+    {
+        CodeState* state = getState(code, line);
+
+        // the rest of the text is highlighted already if the lexer got there in the same state
+        if(*line == '\0' || (line - code->src >= code->syntax.stable && state->temp == lex))
+        {
+            code->syntax.valid = SYNTAX_END;
+            code->syntax.stable = 0;
+            return;
+        }
+
+        if(line >= until) break;
+
+        state->temp = lex;
+        lex = parseLine(config, code->src, code->state, &line, lex);
+    }
 
-    parseCode(config, code->src, code->state);
+    code->syntax.valid = (s32)(line - code->src);
+    code->syntax.lex = lex;
+    code->syntax.stable = MAX(code->syntax.stable, code->syntax.valid);
 }
 
-static char* getLineByPos(Code* code, char* pos)
+// keeps the highlighting consistent with `removed` chars at `pos` replaced by `inserted` ones
+static void invalidateSyntax(Code* code, const char* pos, s32 removed, s32 inserted)
+{
+    s32 offset = (s32)(pos - code->src);
+
+    // relex from the line before the change, the state it's opened in is untouched
+    if(offset < code->syntax.valid)
+    {
+        const char* line = offset ? pos - 1 : pos;
+        while(line > code->src && line[-1] != '\n') line--;
+
+        code->syntax.valid = (s32)(line - code->src);
+        code->syntax.lex = line > code->src ? getState(code, line)->temp : LexState_Code;
+    }
+
+    // the old highlighting only holds from the first untouched line after the change
+    s32 stable = code->syntax.stable;
+
+    if(stable != SYNTAX_END)
+    {
+        if(stable >= offset + removed)
+            stable += inserted - removed;
+
+        if(stable <= offset + inserted)
+        {
+            const char* next = strchr(pos + inserted, '\n');
+            stable = next ? (s32)(next + 1 - code->src) : SYNTAX_END;
+        }
+
+        code->syntax.stable = stable;
+    }
+}
+
+static void parseSyntaxColor(Code* code)
 {
-    char* text = code->src;
-    char* line = text;
+    // the visible lines and a screen of margin, plus the cursor line for the matched delimiters
+    const char* until = getPosByLine(code, code->scroll.y + TEXT_BUFFER_HEIGHT * 2);
+    const char* cursor = getNextLineByPos(code, code->cursor.position);
 
-    while(text < pos)
-        if(*text++ == '\n')
-            line = text;
+    parseSyntax(code, MAX(until, cursor));
+}
 
-    return line;
+static char* getLineByPos(Code* code, char* pos)
+{
+    return getPosByLine(code, getLineIndex(code, pos));
 }
 
 static char* getLine(Code* code)
@@ -632,18 +848,7 @@ static char* getLine(Code* code)
 
 static char* getPrevLineByPos(Code* code, char* pos)
 {
-    char* text = code->src;
-    char* prevLine = text;
-    char* line = text;
-
-    while(text < pos)
-        if(*text++ == '\n')
-        {
-            prevLine = line;
-            line = text;
-        }
-
-    return prevLine;
+    return getPosByLine(code, MAX(getLineIndex(code, pos) - 1, 0));
 }
 
 static char* getPrevLine(Code* code)
@@ -678,35 +883,9 @@ static void updateCursorPosition(Code* code, char* position)
 
 static void setCursorPosition(Code* code, s32 cx, s32 cy)
 {
-    s32 x = 0;
-    s32 y = 0;
-    char* pointer = code->src;
+    char* line = getPosByLine(code, cy);
 
-    while(*pointer)
-    {
-        if(y == cy && x == cx)
-        {
-            updateCursorPosition(code, pointer);
-            return;
-        }
-
-        if(*pointer == '\n')
-        {
-            if(y == cy && cx > x)
-            {
-                updateCursorPosition(code, pointer);
-                return;
-            }
-
-            x = 0;
-            y++;
-        }
-        else x++;
-
-        pointer++;
-    }
-
-    updateCursorPosition(code, pointer);
+    updateCursorPosition(code, cy >= 0 && cx >= 0 ? line + MIN(cx, getLineSize(line)) : line);
 }
 
 static void endLine(Code* code)
@@ -840,6 +1019,10 @@ static void deleteCode(Code* code, char* start, char* end)
 
     // delete code state
     memmove(getState(code, start), getState(code, end), size * sizeof(CodeState));
+
+    code->step.changed = MIN(code->step.changed, (s32)(start - code->src));
+    reindexLines(code, start, (s32)(end - start), 0);
+    invalidateSyntax(code, start, (s32)(end - start), 0);
 }
 
 static void insertCode(Code* code, char* dst, const char* src)
@@ -855,6 +1038,10 @@ static void insertCode(Code* code, char* dst, const char* src)
         memmove(pos + size, pos, restSize * sizeof(CodeState));
         memset(pos, 0, size * sizeof(CodeState));
     }
+
+    code->step.changed = MIN(code->step.changed, (s32)(dst - code->src));
+    reindexLines(code, dst, 0, size);
+    invalidateSyntax(code, dst, 0, size);
 }
 
 static bool replaceSelection(Code* code)
@@ -1076,6 +1263,8 @@ static void copyFromClipboard(Code* code)
 
 static void update(Code* code)
 {
+    indexLines(code);
+    resetSyntax(code);
     updateEditor(code);
     parseSyntaxColor(code);
 }
@@ -1292,6 +1481,9 @@ static void initOutlineMode(Code* code)
 
     if(config->getOutline)
     {
+        // commented out items are skipped, so everything has to be highlighted
+        parseSyntax(code, code->src + strlen(code->src));
+
         s32 size = 0;
         const tic_outline_item* items = config->getOutline(code->src, &size);
 
@@ -1557,6 +1749,9 @@ static void processKeyboard(Code* code)
         {
             for(CodeState* s = code->state, *end = s + TIC_CODE_SIZE; s != end; ++s)
                 s->bookmark = 0;
+
+            history_mark(code->history, 0, code->packed * sizeof(CodeState));
+            history(code);
         }
         else if(ctrl)
         {
@@ -2265,6 +2460,7 @@ void initCode(Code* code, Studio* studio, tic_code* src)
 {
     bool firstLoad = code->state == NULL;
     FREE(code->state);
+    FREE(code->lines.starts);
     freeAnim(code);
 
     if(code->history) history_delete(code->history);
@@ -2320,7 +2516,12 @@ void initCode(Code* code, Studio* studio, tic_code* src)
 
     code->anim.movie = resetMovie(&code->anim.idle);
 
+    // everything is packed once, then only the text
+    code->packed = TIC_CODE_SIZE;
     packState(code);
+    code->packed = (s32)strlen(code->src) + 1;
+    code->step.changed = TIC_CODE_SIZE;
+
     code->history = history_create(code->state, sizeof(CodeState) * TIC_CODE_SIZE);
 
     update(code);
@@ -2332,5 +2533,6 @@ void freeCode(Code* code)
 
     history_delete(code->history);
     free(code->state);
+    free(code->lines.starts);
     free(code);
 }
@@ -70,6 +70,37 @@ struct Code
         char sym;
     }* state;
 
+    // the text and the state only differ within the longest text since the last load
+    s32 packed;
+
+    struct
+    {
+        // first char changed since the last history step, TIC_CODE_SIZE if none
+        s32 changed;
+
+        // the cursor the state has
+        s32 cursor;
+    } step;
+
+    struct
+    {
+        // offsets of the line starts, kept in sync with the text
+        s32* starts;
+        s32 count;
+        s32 capacity;
+    } lines;
+
+    struct
+    {
+        // the text before `valid` is highlighted and the next line is opened in `lex` state,
+        // the old highlighting from the `stable` line to the end holds if the lexer gets there in the same state
+        s32 valid;
+        s32 stable;
+        u8 lex;
+
+        const tic_script_config* config;
+    } syntax;
+
     struct
     {
         char line[STUDIO_TEXT_BUFFER_WIDTH];
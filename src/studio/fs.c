@@ -23,6 +23,7 @@
 #include "studio.h"
 #include "fs.h"
 #include "net.h"
+#include "store.h"
 
 #if defined(BAREMETALPI) || defined(_3DS)
   #ifdef EN_DEBUG
@@ -40,32 +41,67 @@
 #include <sys/types.h>
 #endif
 
-#if defined(TIC_BUILD_WITH_LUA)
-
-#include <lua.h>
-#include <lauxlib.h>
-#include <lualib.h>
-
-#endif
-
 #if defined(__TIC_WINDOWS__)
 #include <direct.h>
 #include <windows.h>
+#include <sys/utime.h>
 #else
 #include <unistd.h>
+#include <utime.h>
+#endif
+
+#if !defined(BAREMETALPI) && !defined(__EMSCRIPTEN__) && (defined(__TIC_LINUX__) || defined(__TIC_MACOSX__) || defined(__TIC_ANDROID__))
+#define FS_MMAP
+#include <sys/mman.h>
+#include <fcntl.h>
 #endif
 
+#include <limits.h>
+#include <ctype.h>
+
 #if defined(__EMSCRIPTEN__)
 #include <emscripten.h>
 #endif
 
 static const char* PublicDir = TIC_HOST;
 
+#if defined(USE_LIBUV) && defined(BUILD_EDITORS)
+#define FS_ASYNC_ENUM
+#include <uv.h>
+#endif
+
+#include <time.h>
+
+typedef struct FsListing FsListing;
+typedef struct FsScan FsScan;
+
 struct tic_fs
 {
     char dir[TICNAME_MAX];
     char work[TICNAME_MAX];
     tic_net* net;
+
+    // chunks of the carts cached by hash
+    tic_store* store;
+
+#if defined(FS_ASYNC_ENUM)
+    // the store is trimmed on a thread, the carts wait for it under the lock
+    struct
+    {
+        uv_thread_t thread;
+        uv_mutex_t lock;
+        char* dir;
+        bool started;
+    } trim;
+#endif
+
+    // recently enumerated local dirs, most recent first
+    FsListing* listings;
+    u32 generation;
+
+#if defined(FS_ASYNC_ENUM)
+    FsScan* scans;
+#endif
 };
 
 #if defined(__EMSCRIPTEN__)
@@ -165,6 +201,7 @@ static const char* stringToUtf8(const FsString* wstr)
 #define tic_rmdir _wrmdir
 #define tic_stat _wstat
 #define tic_remove _wremove
+#define tic_utime _wutime
 #define tic_fopen _wfopen
 #define tic_mkdir(name) _wmkdir(name)
 #define tic_strncpy wcsncpy
@@ -191,6 +228,7 @@ typedef char FsString;
 #define tic_rmdir rmdir
 #define tic_stat stat
 #define tic_remove remove
+#define tic_utime utime
 #define tic_fopen fopen
 #define tic_mkdir(name) mkdir(name, 0700)
 #define tic_strncpy strncpy
@@ -205,126 +243,316 @@ typedef struct
     void* data;
 } NetDirData;
 
-#if defined(TIC_BUILD_WITH_LUA)
+#if defined(BUILD_EDITORS)
+
+// Directory listing is a Lua chunk with table constructors, like
+// folders = {{name = "Games"}, ...} files = {{hash = "...", filename = "...", name = "...", id = 1}, ...}
+// It's read with a small parser instead of running it in a VM.
+
+#define DIR_MAX_DEPTH 8
 
-static lua_State* netLuaInit(u8* buffer, s32 size)
+typedef struct
 {
-    if (buffer && size)
-    {
-        char* script = calloc(1, size + 1);
-        memcpy(script, buffer, size);
+    const char* ptr;
+    const char* end;
+} DirReader;
 
-        lua_State* lua = luaL_newstate();
+typedef struct
+{
+    NetDirData* dir;
+    bool files;
+} DirListing;
 
-        if(lua)
-        {
-            if(luaL_loadstring(lua, script) == LUA_OK && lua_pcall(lua, 0, LUA_MULTRET, 0) == LUA_OK)
-                return lua;
+typedef struct
+{
+    char name[TICNAME_MAX];
+    char filename[TICNAME_MAX];
+    char hash[TICNAME_MAX];
+    s32 id;
+    bool hasId;
+} DirEntry;
+
+// reads the value of the `key` field (NULL for positional ones)
+typedef bool(*DirFieldHandler)(DirReader* reader, const char* key, s32 depth, void* data);
 
-            else lua_close(lua);
+static void skipSpace(DirReader* reader)
+{
+    while(reader->ptr < reader->end)
+    {
+        if(isspace((u8)*reader->ptr))
+            reader->ptr++;
+        else if(reader->end - reader->ptr >= 2 && reader->ptr[0] == '-' && reader->ptr[1] == '-')
+        {
+            while(reader->ptr < reader->end && *reader->ptr != '\n')
+                reader->ptr++;
         }
+        else break;
+    }
+}
+
+static bool readChar(DirReader* reader, char c)
+{
+    skipSpace(reader);
 
-        free(script);
+    if(reader->ptr < reader->end && *reader->ptr == c)
+    {
+        reader->ptr++;
+        return true;
     }
 
-    return NULL;
+    return false;
 }
 
-static void onDirResponse(const net_get_data* netData)
+// names longer than the buffer are cut
+static bool readName(DirReader* reader, char* name, s32 size)
 {
-    NetDirData* netDirData = (NetDirData*)netData->calldata;
+    skipSpace(reader);
 
-    if(netData->type == net_get_done)
+    const char* start = reader->ptr;
+
+    if(reader->ptr < reader->end && (isalpha((u8)*reader->ptr) || *reader->ptr == '_'))
+        while(reader->ptr < reader->end && (isalnum((u8)*reader->ptr) || *reader->ptr == '_'))
+            reader->ptr++;
+
+    s32 len = MIN((s32)(reader->ptr - start), size - 1);
+    memcpy(name, start, len);
+    name[len] = '\0';
+
+    return reader->ptr != start;
+}
+
+// strings longer than the buffer are cut, NULL buffer skips the string
+static bool readString(DirReader* reader, char* out, s32 size)
+{
+    skipSpace(reader);
+
+    if(reader->ptr >= reader->end || (*reader->ptr != '"' && *reader->ptr != '\''))
+        return false;
+
+    char quote = *reader->ptr++;
+    s32 len = 0;
+
+    while(reader->ptr < reader->end && *reader->ptr != quote)
     {
-        lua_State* lua = netLuaInit(netData->done.data, netData->done.size);
+        char c = *reader->ptr++;
 
-        if (lua)
+        if(c == '\n')
+            return false;
+
+        if(c == '\\' && reader->ptr < reader->end)
         {
+            switch(c = *reader->ptr++)
             {
-                lua_getglobal(lua, "folders");
-
-                if (lua_type(lua, -1) == LUA_TTABLE)
+            case 'n': c = '\n'; break;
+            case 'r': c = '\r'; break;
+            case 't': c = '\t'; break;
+            default:
+                if(isdigit((u8)c))
                 {
-                    s32 count = (s32)lua_rawlen(lua, -1);
+                    s32 code = c - '0';
 
-                    for (s32 i = 1; i <= count; i++)
-                    {
-                        lua_geti(lua, -1, i);
+                    for(s32 i = 0; i < 2 && reader->ptr < reader->end && isdigit((u8)*reader->ptr); i++)
+                        code = code * 10 + (*reader->ptr++ - '0');
 
-                        {
-                            lua_getfield(lua, -1, "name");
-                            if (lua_isstring(lua, -1))
-                                netDirData->item(lua_tostring(lua, -1), NULL, NULL, 0, netDirData->data, true);
+                    if(code > UINT8_MAX)
+                        return false;
 
-                            lua_pop(lua, 1);
-                        }
-
-                        lua_pop(lua, 1);
-                    }
+                    c = (char)code;
                 }
-
-                lua_pop(lua, 1);
             }
+        }
 
-            {
-                lua_getglobal(lua, "files");
+        if(out && len < size - 1)
+            out[len++] = c;
+    }
 
-                if (lua_type(lua, -1) == LUA_TTABLE)
-                {
-                    s32 count = (s32)lua_rawlen(lua, -1);
+    if(reader->ptr >= reader->end)
+        return false;
 
-                    for (s32 i = 1; i <= count; i++)
-                    {
-                        lua_geti(lua, -1, i);
+    reader->ptr++;
 
-                        char hash[TICNAME_MAX];
-                        char name[TICNAME_MAX];
-                        char title[TICNAME_MAX];
+    if(out)
+        out[len] = '\0';
 
-                        {
-                            lua_getfield(lua, -1, "hash");
-                            if (lua_isstring(lua, -1))
-                                strncpy(hash, lua_tostring(lua, -1), sizeof hash);
+    return true;
+}
 
-                            lua_pop(lua, 1);
-                        }
+// `integer` is false for fractions, exponents and hex numbers
+static bool readNumber(DirReader* reader, s32* value, bool* integer)
+{
+    skipSpace(reader);
+
+    const char* start = reader->ptr;
+    bool negative = reader->ptr < reader->end && *reader->ptr == '-';
 
-                        {
-                            lua_getfield(lua, -1, "filename");
+    if(negative)
+        reader->ptr++;
 
-                            if (lua_isstring(lua, -1))
-                                strncpy(name, lua_tostring(lua, -1), sizeof name);
+    s64 result = 0;
+    const char* digits = reader->ptr;
 
-                            lua_pop(lua, 1);
-                        }
+    for(; reader->ptr < reader->end && isdigit((u8)*reader->ptr); reader->ptr++)
+        result = MIN(result * 10 + (*reader->ptr - '0'), (s64)INT32_MAX);
 
-                        {
-                            lua_getfield(lua, -1, "name");
+    if(reader->ptr == digits)
+    {
+        reader->ptr = start;
+        return false;
+    }
 
-                            if (lua_isstring(lua, -1))
-                                strncpy(title, lua_tostring(lua, -1), sizeof title);
+    *integer = true;
 
-                            lua_pop(lua, 1);
-                        }
+    while(reader->ptr < reader->end && (isalnum((u8)*reader->ptr) || *reader->ptr == '.'))
+    {
+        *integer = false;
+        reader->ptr++;
+    }
 
-                        {
-                            lua_getfield(lua, -1, "id");
+    *value = (s32)(negative ? -result : result);
 
-                            if (lua_isinteger(lua, -1))
-                                netDirData->item(name, title, hash, (s32)lua_tointeger(lua, -1), netDirData->data, false);
+    return true;
+}
 
-                            lua_pop(lua, 1);
-                        }
+static bool skipValue(DirReader* reader, s32 depth);
 
-                        lua_pop(lua, 1);
-                    }
-                }
+// reads table fields after the opening brace
+static bool readTable(DirReader* reader, s32 depth, DirFieldHandler handler, void* data)
+{
+    if(depth > DIR_MAX_DEPTH)
+        return false;
 
-                lua_pop(lua, 1);
-            }
+    while(!readChar(reader, '}'))
+    {
+        char key[16] = "";
+        const char* start = reader->ptr;
 
-            lua_close(lua);
+        if(readChar(reader, '['))
+        {
+            if(!(readString(reader, key, sizeof key) || skipValue(reader, depth)) 
+                || !readChar(reader, ']') || !readChar(reader, '='))
+                return false;
+        }
+        else if(!readName(reader, key, sizeof key) || !readChar(reader, '='))
+        {
+            // positional value
+            reader->ptr = start;
+            *key = '\0';
         }
+
+        if(!(handler ? handler(reader, *key ? key : NULL, depth, data) : skipValue(reader, depth)))
+            return false;
+
+        if(!readChar(reader, ',') && !readChar(reader, ';'))
+            return readChar(reader, '}');
+    }
+
+    return true;
+}
+
+static bool skipValue(DirReader* reader, s32 depth)
+{
+    char name[8];
+    s32 number;
+    bool integer;
+
+    if(readChar(reader, '{'))
+        return readTable(reader, depth + 1, NULL, NULL);
+
+    return readString(reader, NULL, 0) 
+        || readNumber(reader, &number, &integer)
+        || readName(reader, name, sizeof name);
+}
+
+static bool readEntryField(DirReader* reader, const char* key, s32 depth, void* data)
+{
+    DirEntry* entry = data;
+
+    if(key)
+    {
+        if(strcmp(key, "name") == 0)
+            return readString(reader, entry->name, sizeof entry->name) || skipValue(reader, depth);
+        if(strcmp(key, "filename") == 0)
+            return readString(reader, entry->filename, sizeof entry->filename) || skipValue(reader, depth);
+        if(strcmp(key, "hash") == 0)
+            return readString(reader, entry->hash, sizeof entry->hash) || skipValue(reader, depth);
+        if(strcmp(key, "id") == 0)
+            return readNumber(reader, &entry->id, &entry->hasId) || skipValue(reader, depth);
+    }
+
+    return skipValue(reader, depth);
+}
+
+static bool readEntry(DirReader* reader, const char* key, s32 depth, void* data)
+{
+    DirListing* listing = data;
+    NetDirData* dir = listing->dir;
+
+    if(!readChar(reader, '{'))
+        return skipValue(reader, depth);
+
+    DirEntry entry = {0};
+
+    if(!readTable(reader, depth + 1, readEntryField, &entry))
+        return false;
+
+    if(listing->files)
+        return entry.hasId 
+            ? dir->item(entry.filename, entry.name, entry.hash, entry.id, dir->data, false) 
+            : true;
+
+    return *entry.name 
+        ? dir->item(entry.name, NULL, NULL, 0, dir->data, true) 
+        : true;
+}
+
+static bool readList(DirReader* reader, const char* key, s32 depth, void* data)
+{
+    DirListing* listing = data;
+
+    if(key && strcmp(key, listing->files ? "files" : "folders") == 0 && readChar(reader, '{'))
+        return readTable(reader, depth + 1, readEntry, listing);
+
+    return skipValue(reader, depth);
+}
+
+// emits folders or files of the listing, stops on a syntax error
+static void readListing(const u8* buffer, s32 size, DirListing* listing)
+{
+    DirReader reader = {(const char*)buffer, (const char*)buffer + size};
+
+    for(skipSpace(&reader); reader.ptr < reader.end; skipSpace(&reader))
+    {
+        char name[16];
+
+        if(!readName(&reader, name, sizeof name))
+            return;
+
+        if(strcmp(name, "return") == 0)
+        {
+            if(!readChar(&reader, '{') || !readTable(&reader, 0, readList, listing))
+                return;
+        }
+        else
+        {
+            if(strcmp(name, "local") == 0 && !readName(&reader, name, sizeof name))
+                return;
+
+            if(!readChar(&reader, '=') || !readList(&reader, name, 0, listing))
+                return;
+        }
+
+        readChar(&reader, ';');
+    }
+}
+
+static void onDirResponse(const net_get_data* netData)
+{
+    NetDirData* netDirData = (NetDirData*)netData->calldata;
+
+    if(netData->type == net_get_done)
+    {
+        readListing(netData->done.data, netData->done.size, &(DirListing){netDirData, false});
+        readListing(netData->done.data, netData->done.size, &(DirListing){netDirData, true});
     }
 
     switch (netData->type)
@@ -340,7 +568,7 @@ static void onDirResponse(const net_get_data* netData)
 
 #endif
 
-static void enumFiles(tic_fs* fs, const char* path, fs_list_callback callback, void* data)
+static void enumFiles(const char* path, fs_list_callback callback, void* data)
 {
 #if defined(BAREMETALPI)
     dbg("enumFiles %s", path);
@@ -418,6 +646,357 @@ static void enumFiles(tic_fs* fs, const char* path, fs_list_callback callback, v
 #endif
 }
 
+#if !defined(BAREMETALPI)
+
+// Local listings are kept with the dir modification time they were read at
+// and reused while it doesn't change, so a repeated `dir` or tab completion
+// costs a single stat instead of a stat per entry. Uncached dirs are scanned
+// on a worker and the entries are delivered in batches on the main loop.
+
+#define FS_LISTINGS 16
+#define FS_SCAN_BATCH 64
+
+typedef struct
+{
+    char* name;
+    bool dir;
+} FsEntry;
+
+struct FsListing
+{
+    char* path;
+    u64 date;
+    FsEntry* entries;
+    s32 count;
+    s32 capacity;
+    FsListing* next;
+};
+
+struct FsScan
+{
+    tic_fs* fs;
+    FsListing* listing;
+    u32 generation;
+    s32 delivered;
+    bool cacheable;
+    bool complete;
+    bool stopped;
+
+    fs_list_callback onItem;
+    fs_done_callback onDone;
+    void* data;
+
+#if defined(FS_ASYNC_ENUM)
+    uv_work_t work;
+    uv_async_t async;
+    uv_mutex_t mutex;
+    bool threaded;
+    FsScan* next;
+#endif
+};
+
+static u64 dirDate(const char* path)
+{
+    char dir[TICNAME_MAX];
+    strncpy(dir, path, sizeof dir - 1);
+    dir[sizeof dir - 1] = '\0';
+
+    // some platforms refuse to stat a dir with the trailing separator
+    size_t len = strlen(dir);
+    if(len > 1 && (dir[len - 1] == '/' || dir[len - 1] == '\\') && dir[len - 2] != ':')
+        dir[len - 1] = '\0';
+
+    struct tic_stat_struct s;
+
+    const FsString* pathString = utf8ToString(dir);
+    s32 ret = tic_stat(pathString, &s);
+    freeString(pathString);
+
+    return ret == 0 && S_ISDIR(s.st_mode) ? s.st_mtime : 0;
+}
+
+static void freeListing(FsListing* listing)
+{
+    for(s32 i = 0; i < listing->count; i++)
+        free(listing->entries[i].name);
+
+    free(listing->entries);
+    free(listing->path);
+    free(listing);
+}
+
+static void clearListings(tic_fs* fs)
+{
+    while(fs->listings)
+    {
+        FsListing* next = fs->listings->next;
+        freeListing(fs->listings);
+        fs->listings = next;
+    }
+
+    // scans started before the change mustn't store what they've read
+    fs->generation++;
+}
+
+static FsListing* findListing(tic_fs* fs, const char* path)
+{
+    for(FsListing **ptr = &fs->listings, *listing; (listing = *ptr); ptr = &listing->next)
+    {
+        if(strcmp(listing->path, path) == 0)
+        {
+            *ptr = listing->next;
+
+            if(listing->date && listing->date == dirDate(path))
+            {
+                listing->next = fs->listings;
+                fs->listings = listing;
+                return listing;
+            }
+
+            freeListing(listing);
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static void storeListing(tic_fs* fs, FsListing* listing)
+{
+    FsListing** ptr = &fs->listings;
+
+    for(s32 count = 0; *ptr;)
+    {
+        FsListing* item = *ptr;
+
+        if(strcmp(item->path, listing->path) == 0 || ++count >= FS_LISTINGS)
+        {
+            *ptr = item->next;
+            freeListing(item);
+        }
+        else ptr = &item->next;
+    }
+
+    listing->next = fs->listings;
+    fs->listings = listing;
+}
+
+static bool addEntry(FsListing* listing, const char* name, bool dir)
+{
+    if(listing->count == listing->capacity)
+    {
+        s32 capacity = listing->capacity ? listing->capacity * 2 : FS_SCAN_BATCH;
+        FsEntry* entries = realloc(listing->entries, capacity * sizeof(FsEntry));
+
+        if(!entries)
+            return false;
+
+        listing->entries = entries;
+        listing->capacity = capacity;
+    }
+
+    char* copy = strdup(name);
+
+    if(!copy)
+        return false;
+
+    listing->entries[listing->count++] = (FsEntry){copy, dir};
+
+    return true;
+}
+
+static void deliverScan(FsScan* scan)
+{
+    const FsListing* listing = scan->listing;
+
+    while(!scan->stopped && scan->delivered < listing->count)
+    {
+        const FsEntry* entry = &listing->entries[scan->delivered++];
+
+        if(!scan->onItem(entry->name, NULL, NULL, 0, scan->data, entry->dir))
+            scan->stopped = true;
+    }
+}
+
+static bool collectEntry(const char* name, const char* title, const char* hash, s32 id, void* data, bool dir)
+{
+    FsScan* scan = data;
+
+#if defined(FS_ASYNC_ENUM)
+    if(scan->threaded)
+    {
+        uv_mutex_lock(&scan->mutex);
+
+        bool result = !scan->stopped && addEntry(scan->listing, name, dir);
+        bool batch = scan->listing->count % FS_SCAN_BATCH == 0;
+
+        uv_mutex_unlock(&scan->mutex);
+
+        if(batch)
+            uv_async_send(&scan->async);
+
+        return result;
+    }
+#endif
+
+    return !scan->stopped && addEntry(scan->listing, name, dir);
+}
+
+static void scanDir(FsScan* scan)
+{
+    const char* path = scan->listing->path;
+    u64 date = dirDate(path);
+
+    // an entry added later within the same second wouldn't change the date
+    scan->listing->date = date;
+    scan->cacheable = date && date < (u64)time(NULL);
+
+    enumFiles(path, collectEntry, scan);
+
+#if defined(FS_ASYNC_ENUM)
+    if(scan->threaded)
+    {
+        uv_mutex_lock(&scan->mutex);
+        scan->complete = !scan->stopped;
+        uv_mutex_unlock(&scan->mutex);
+        return;
+    }
+#endif
+
+    scan->complete = !scan->stopped;
+}
+
+static void finishScan(FsScan* scan)
+{
+    tic_fs* fs = scan->fs;
+
+    if(fs)
+    {
+        if(scan->cacheable && scan->complete && scan->generation == fs->generation)
+        {
+            storeListing(fs, scan->listing);
+            scan->listing = NULL;
+        }
+
+        scan->onDone(scan->data);
+    }
+}
+
+static void freeScan(FsScan* scan)
+{
+    if(scan->listing)
+        freeListing(scan->listing);
+
+    free(scan);
+}
+
+#if defined(FS_ASYNC_ENUM)
+
+static void onScanWork(uv_work_t* work)
+{
+    scanDir(work->data);
+}
+
+static void onScanProgress(uv_async_t* async)
+{
+    FsScan* scan = async->data;
+
+    uv_mutex_lock(&scan->mutex);
+
+    if(scan->fs)
+        deliverScan(scan);
+
+    uv_mutex_unlock(&scan->mutex);
+}
+
+static void onScanClosed(uv_handle_t* handle)
+{
+    FsScan* scan = handle->data;
+
+    uv_mutex_destroy(&scan->mutex);
+    freeScan(scan);
+}
+
+static void onScanDone(uv_work_t* work, s32 status)
+{
+    FsScan* scan = work->data;
+    tic_fs* fs = scan->fs;
+
+    if(fs)
+    {
+        for(FsScan** ptr = &fs->scans; *ptr; ptr = &(*ptr)->next)
+        {
+            if(*ptr == scan)
+            {
+                *ptr = scan->next;
+                break;
+            }
+        }
+
+        deliverScan(scan);
+    }
+
+    finishScan(scan);
+
+    uv_close((uv_handle_t*)&scan->async, onScanClosed);
+}
+
+#endif
+
+static void startScan(tic_fs* fs, const char* path, fs_list_callback onItem, fs_done_callback onDone, void* data)
+{
+    FsScan* scan = NEW(FsScan);
+    FsListing* listing = NEW(FsListing);
+
+    *listing = (FsListing){.path = strdup(path)};
+    *scan = (FsScan)
+    {
+        .fs = fs,
+        .listing = listing,
+        .generation = fs->generation,
+        .onItem = onItem,
+        .onDone = onDone,
+        .data = data,
+    };
+
+#if defined(FS_ASYNC_ENUM)
+    uv_loop_t* loop = uv_default_loop();
+
+    if(uv_mutex_init(&scan->mutex) == 0)
+    {
+        if(uv_async_init(loop, &scan->async, onScanProgress) == 0)
+        {
+            scan->async.data = scan->work.data = scan;
+            scan->threaded = true;
+
+            if(uv_queue_work(loop, &scan->work, onScanWork, onScanDone) == 0)
+            {
+                scan->next = fs->scans;
+                fs->scans = scan;
+                return;
+            }
+
+            // no worker, the scan is freed when the handle is closed
+            scan->threaded = false;
+            scanDir(scan);
+            deliverScan(scan);
+            finishScan(scan);
+            uv_close((uv_handle_t*)&scan->async, onScanClosed);
+            return;
+        }
+
+        uv_mutex_destroy(&scan->mutex);
+    }
+#endif
+
+    scanDir(scan);
+    deliverScan(scan);
+    finishScan(scan);
+    freeScan(scan);
+}
+
+#endif
+
 void tic_fs_enum(tic_fs* fs, fs_list_callback onItem, fs_done_callback onDone, void* data)
 {
     if (isRoot(fs) && !onItem(PublicDir, NULL, NULL, 0, data, true))
@@ -426,7 +1005,7 @@ void tic_fs_enum(tic_fs* fs, fs_list_callback onItem, fs_done_callback onDone, v
         return;
     }
 
-#if defined(TIC_BUILD_WITH_LUA) && defined(BUILD_EDITORS)
+#if defined(BUILD_EDITORS)
     if(isPublic(fs))
     {
         char request[TICNAME_MAX];
@@ -441,7 +1020,25 @@ void tic_fs_enum(tic_fs* fs, fs_list_callback onItem, fs_done_callback onDone, v
 
     const char* path = tic_fs_path(fs, "");
 
-    enumFiles(fs, path, onItem, data);
+#if defined(BAREMETALPI)
+    enumFiles(path, onItem, data);
+#else
+    const FsListing* listing = findListing(fs, path);
+
+    if(!listing)
+    {
+        startScan(fs, path, onItem, onDone, data);
+        return;
+    }
+
+    for(s32 i = 0; i < listing->count; i++)
+    {
+        const FsEntry* entry = &listing->entries[i];
+
+        if(!onItem(entry->name, NULL, NULL, 0, data, entry->dir))
+            break;
+    }
+#endif
 
     onDone(data);
 }
@@ -453,6 +1050,8 @@ bool tic_fs_deldir(tic_fs* fs, const char* name)
     dbg("tic_fs_deldir %s", name);
     return 0;
 #else
+    clearListings(fs);
+
 #if defined(__TIC_WINDOWS__)
     const char* path = tic_fs_path(fs, name);
 
@@ -479,6 +1078,8 @@ bool tic_fs_delfile(tic_fs* fs, const char* name)
     // TODO BAREMETALPI
     return false;
 #else
+    clearListings(fs);
+
     const char* path = tic_fs_path(fs, name);
 
     const FsString* pathString = utf8ToString(path);
@@ -576,6 +1177,16 @@ bool tic_fs_isdir(tic_fs* fs, const char* name)
 
     return s.fattrib & AM_DIR;
 #else
+    if(!strpbrk(name, "/\\"))
+    {
+        const FsListing* listing = findListing(fs, tic_fs_path(fs, ""));
+
+        if(listing)
+            for(s32 i = 0; i < listing->count; i++)
+                if(strcmp(listing->entries[i].name, name) == 0)
+                    return listing->entries[i].dir;
+    }
+
     const char* path = tic_fs_path(fs, name);
     struct tic_stat_struct s;
     const FsString* pathString = utf8ToString(path);
@@ -625,24 +1236,125 @@ bool fs_write(const char* name, const void* buffer, s32 size)
     }
     return true;
 #else
-    const FsString* pathString = utf8ToString(name);
-    FILE* file = tic_fopen(pathString, _S("wb"));
+    const FsString* pathString = utf8ToString(name);
+    FILE* file = tic_fopen(pathString, _S("wb"));
+    freeString(pathString);
+
+    if(file)
+    {
+        fwrite(buffer, 1, size, file);
+        fclose(file);
+
+#if defined(__EMSCRIPTEN__)
+        syncfs();
+#endif
+
+        return true;
+    }
+
+    return false;
+#endif
+}
+
+bool fs_replace(const char* name, const void* buffer, s32 size)
+{
+#if defined(BAREMETALPI)
+    return fs_write(name, buffer, size);
+#else
+    static const char TempExt[] = ".tmp";
+
+    char* temp = malloc(strlen(name) + sizeof TempExt);
+    sprintf(temp, "%s%s", name, TempExt);
+
+    bool done = false;
+    const FsString* tempString = utf8ToString(temp);
+    FILE* file = tic_fopen(tempString, _S("wb"));
+
+    if(file)
+    {
+        done = fwrite(buffer, 1, size, file) == size;
+        done = fclose(file) == 0 && done;
+
+        if(done)
+        {
+            const FsString* pathString = utf8ToString(name);
+#if defined(__TIC_WINDOWS__)
+            done = MoveFileExW(tempString, pathString, MOVEFILE_REPLACE_EXISTING);
+#else
+            done = rename(tempString, pathString) == 0;
+#endif
+            freeString(pathString);
+        }
+
+        if(!done)
+            tic_remove(tempString);
+
+#if defined(__EMSCRIPTEN__)
+        syncfs();
+#endif
+    }
+
+    freeString(tempString);
+    free(temp);
+
+    return done;
+#endif
+}
+
+struct fs_file
+{
+#if defined(BAREMETALPI)
+    FIL file;
+#else
+    FILE* file;
+#endif
+};
+
+fs_file* fs_file_create(const char* path)
+{
+    fs_file* file = calloc(1, sizeof(fs_file));
+
+#if defined(BAREMETALPI)
+    dbg("fs_file_create %s\n", path);
+    if(f_open(&file->file, path, FA_WRITE | FA_CREATE_ALWAYS) == FR_OK)
+        return file;
+#else
+    const FsString* pathString = utf8ToString(path);
+    file->file = tic_fopen(pathString, _S("wb"));
     freeString(pathString);
 
-    if(file)
-    {
-        fwrite(buffer, 1, size, file);
-        fclose(file);
+    if(file->file)
+        return file;
+#endif
 
-#if defined(__EMSCRIPTEN__)
-        syncfs();
+    free(file);
+    return NULL;
+}
+
+bool fs_file_write(fs_file* file, const void* data, s32 size)
+{
+#if defined(BAREMETALPI)
+    u32 written = 0;
+    return f_write(&file->file, data, size, &written) == FR_OK && written == size;
+#else
+    return fwrite(data, 1, size, file->file) == size;
 #endif
+}
 
-        return true;
-    }
+void fs_file_close(fs_file* file)
+{
+#if defined(BAREMETALPI)
+    f_close(&file->file);
+#else
+    fclose(file->file);
+
+#if defined(__EMSCRIPTEN__)
+    syncfs();
+#endif
 
-    return false;
 #endif
+
+    free(file);
 }
 
 void* fs_read(const char* path, s32* size)
@@ -689,6 +1401,92 @@ void* fs_read(const char* path, s32* size)
 #endif
 }
 
+static bool mapFile(const char* path, fs_view* view)
+{
+#if defined(__TIC_WINDOWS__)
+    const FsString* pathString = utf8ToString(path);
+    HANDLE file = CreateFileW(pathString, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    freeString(pathString);
+
+    if(file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    void* data = NULL;
+
+    if(GetFileSizeEx(file, &size) && size.QuadPart > 0 && size.QuadPart < INT_MAX)
+    {
+        HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+        if(mapping)
+        {
+            // the view keeps the mapping alive
+            data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+    }
+
+    CloseHandle(file);
+
+    if(data)
+        *view = (fs_view){data, (s32)size.QuadPart, true};
+
+    return data != NULL;
+
+#elif defined(FS_MMAP)
+    s32 fd = open(path, O_RDONLY);
+
+    if(fd < 0)
+        return false;
+
+    struct stat st;
+    void* data = MAP_FAILED;
+
+    if(fstat(fd, &st) == 0 && st.st_size > 0 && st.st_size < INT_MAX)
+        data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if(data == MAP_FAILED)
+        return false;
+
+    *view = (fs_view){data, (s32)st.st_size, true};
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool fs_view_open(const char* path, fs_view* view)
+{
+    if(mapFile(path, view))
+        return true;
+
+    // empty files and platforms without mapping go through the buffered read
+    s32 size = 0;
+    void* data = fs_read(path, &size);
+
+    *view = (fs_view){data, data ? size : 0, false};
+
+    return data != NULL;
+}
+
+void fs_view_close(fs_view* view)
+{
+    if(view->mapped)
+    {
+#if defined(__TIC_WINDOWS__)
+        UnmapViewOfFile(view->data);
+#elif defined(FS_MMAP)
+        munmap((void*)view->data, view->size);
+#endif
+    }
+    else free((void*)view->data);
+
+    *view = (fs_view){0};
+}
+
 bool fs_exists(const char* name)
 {
 #if defined(BAREMETALPI)
@@ -735,6 +1533,155 @@ u64 fs_date(const char* path)
 #endif
 }
 
+static bool hasExt(const char* name, const char* ext)
+{
+    size_t nameLen = strlen(name), extLen = strlen(ext);
+    return nameLen > extLen && strcmp(name + nameLen - extLen, ext) == 0;
+}
+
+void fs_files(const char* path, const char* ext, fs_file_callback callback, void* data)
+{
+#if defined(BAREMETALPI)
+    dbg("fs_files %s\n", path);
+    // TODO BAREMETALPI
+#else
+    TIC_DIR *dir = NULL;
+    struct tic_dirent* ent = NULL;
+
+    const FsString* pathString = utf8ToString(path);
+
+    if ((dir = tic_opendir(pathString)) != NULL)
+    {
+        FsString fullPath[TICNAME_MAX];
+        struct tic_stat_struct s;
+
+        while ((ent = tic_readdir(dir)) != NULL)
+        {
+            if(*ent->d_name == _S('.'))
+                continue;
+
+            const char* name = stringToUtf8(ent->d_name);
+            bool result = true;
+
+            if(!ext || hasExt(name, ext))
+            {
+                tic_strncpy(fullPath, pathString, COUNT_OF(fullPath));
+                tic_strncat(fullPath, ent->d_name, COUNT_OF(fullPath));
+
+                if(tic_stat(fullPath, &s) == 0 && S_ISREG(s.st_mode))
+                    result = callback(name, s.st_size, s.st_mtime, data);
+            }
+
+            freeString(name);
+
+            if(!result) break;
+        }
+
+        tic_closedir(dir);
+    }
+
+    freeString(pathString);
+#endif
+}
+
+bool fs_remove(const char* path)
+{
+#if defined(BAREMETALPI)
+    dbg("fs_remove %s\n", path);
+    // TODO BAREMETALPI
+    return false;
+#else
+    const FsString* pathString = utf8ToString(path);
+    bool done = tic_remove(pathString) == 0;
+    freeString(pathString);
+
+    return done;
+#endif
+}
+
+void fs_touch(const char* path)
+{
+#if defined(BAREMETALPI)
+    dbg("fs_touch %s\n", path);
+    // TODO BAREMETALPI
+#else
+    const FsString* pathString = utf8ToString(path);
+    tic_utime(pathString, NULL);
+    freeString(pathString);
+#endif
+}
+
+typedef struct
+{
+    char* name;
+    s64 size;
+    u64 date;
+} TrimFile;
+
+typedef struct
+{
+    TrimFile* files;
+    s32 count;
+    s32 capacity;
+} TrimList;
+
+static bool addTrimFile(const char* name, s64 size, u64 date, void* data)
+{
+    TrimList* list = data;
+
+    if(list->count == list->capacity)
+    {
+        list->capacity = list->capacity ? list->capacity * 2 : 64;
+        list->files = realloc(list->files, list->capacity * sizeof(TrimFile));
+    }
+
+    list->files[list->count++] = (TrimFile){strdup(name), size, date};
+
+    return true;
+}
+
+static s32 compareTrimFiles(const void* a, const void* b)
+{
+    const TrimFile *left = a, *right = b;
+
+    // newest first
+    return left->date < right->date ? 1 : left->date > right->date ? -1 : 0;
+}
+
+void fs_trim(const char* path, const char* ext, s64 limit)
+{
+    TrimList list = {0};
+    fs_files(path, ext, addTrimFile, &list);
+
+    if(list.count)
+        qsort(list.files, list.count, sizeof(TrimFile), compareTrimFiles);
+
+    s64 total = 0;
+    bool removed = false;
+
+    for(TrimFile *file = list.files, *end = file + list.count; file != end; file++)
+    {
+        if((total += file->size) > limit)
+        {
+            char* name = malloc(strlen(path) + strlen(file->name) + 1);
+            sprintf(name, "%s%s", path, file->name);
+            removed |= fs_remove(name);
+            free(name);
+        }
+
+        free(file->name);
+    }
+
+    free(list.files);
+
+#if defined(__EMSCRIPTEN__)
+    if(removed)
+        syncfs();
+#else
+    (void)removed;
+#endif
+}
+
 bool tic_fs_save(tic_fs* fs, const char* name, const void* data, s32 size, bool overwrite)
 {
     if(!overwrite)
@@ -743,6 +1690,8 @@ bool tic_fs_save(tic_fs* fs, const char* name, const void* data, s32 size, bool
             return false;
     }
 
+    clearListings(fs);
+
     return fs_write(tic_fs_path(fs, name), data, size);
 }
 
@@ -756,6 +1705,8 @@ bool tic_fs_saveroot(tic_fs* fs, const char* name, const void* data, s32 size, b
             return false;
     }
 
+    clearListings(fs);
+
     return fs_write(path, data, size);
 }
 
@@ -767,13 +1718,128 @@ typedef struct
     char* cachePath;
 } LoadFileByHashData;
 
+#if !defined(BAREMETALPI)
+
+#define STORE_MANIFEST_EXT ".cart"
+#define STORE_SIZE (64 * 1024 * 1024)
+#define STORE_AGE (90 * 24 * 60 * 60)
+
+#if defined(FS_ASYNC_ENUM)
+
+static void trimStore(void* data)
+{
+    tic_fs* fs = data;
+
+    uv_mutex_lock(&fs->trim.lock);
+    tic_store_trim(fs->store, fs->trim.dir, STORE_MANIFEST_EXT, STORE_SIZE, STORE_AGE);
+    uv_mutex_unlock(&fs->trim.lock);
+}
+
+// the store is opened with the fs, so the trim is usually done by the first cart
+static void openStore(tic_fs* fs)
+{
+    fs->store = tic_store_create(tic_fs_pathroot(fs, TIC_STORE));
+    fs->trim.dir = strdup(tic_fs_pathroot(fs, TIC_CACHE));
+
+    uv_mutex_init(&fs->trim.lock);
+    fs->trim.started = uv_thread_create(&fs->trim.thread, trimStore, fs) == 0;
+}
+
+static void closeStore(tic_fs* fs)
+{
+    if(fs->trim.started)
+        uv_thread_join(&fs->trim.thread);
+
+    uv_mutex_destroy(&fs->trim.lock);
+    free(fs->trim.dir);
+}
+
+#endif
+
+// the store is locked while it's used, the trim thread can be running
+static tic_store* lockStore(tic_fs* fs)
+{
+#if defined(FS_ASYNC_ENUM)
+    uv_mutex_lock(&fs->trim.lock);
+#else
+    if(!fs->store)
+    {
+        fs->store = tic_store_create(tic_fs_pathroot(fs, TIC_STORE));
+        tic_store_trim(fs->store, tic_fs_pathroot(fs, TIC_CACHE), STORE_MANIFEST_EXT, STORE_SIZE, STORE_AGE);
+    }
+#endif
+
+    return fs->store;
+}
+
+static void unlockStore(tic_fs* fs)
+{
+#if defined(FS_ASYNC_ENUM)
+    uv_mutex_unlock(&fs->trim.lock);
+#endif
+}
+
+static char* manifestPath(tic_fs* fs, const char* cachePath)
+{
+    const char* path = tic_fs_pathroot(fs, cachePath);
+    char* manifest = malloc(strlen(path) + sizeof STORE_MANIFEST_EXT);
+
+    // cache/<hash>.tic -> cache/<hash>.cart
+    strcpy(manifest, path);
+    char* ext = strrchr(manifest, '.');
+    strcpy(ext ? ext : manifest + strlen(manifest), STORE_MANIFEST_EXT);
+
+    return manifest;
+}
+
+// carts are cached in the chunk store, plain files are left for the data it can't split
+static void saveCachedCart(tic_fs* fs, const char* cachePath, const void* data, s32 size)
+{
+    char* manifest = manifestPath(fs, cachePath);
+    bool stored = tic_store_save(lockStore(fs), manifest, data, size);
+    unlockStore(fs);
+
+    if(!stored)
+        tic_fs_saveroot(fs, cachePath, data, size, false);
+
+    free(manifest);
+}
+
+static void* loadCachedCart(tic_fs* fs, const char* cachePath, s32* size)
+{
+    char* manifest = manifestPath(fs, cachePath);
+    void* buffer = tic_store_load(lockStore(fs), manifest, size);
+    unlockStore(fs);
+    free(manifest);
+
+    if(!buffer && (buffer = tic_fs_loadroot(fs, cachePath, size)))
+    {
+        // move the carts cached before the store into it
+        char* manifest = manifestPath(fs, cachePath);
+
+        bool stored = tic_store_save(lockStore(fs), manifest, buffer, *size);
+        unlockStore(fs);
+
+        if(stored)
+        {
+            const FsString* pathString = utf8ToString(tic_fs_pathroot(fs, cachePath));
+            tic_remove(pathString);
+            freeString(pathString);
+        }
+
+        free(manifest);
+    }
+
+    return buffer;
+}
+
 static void fileByHashLoaded(const net_get_data* netData)
 {
     LoadFileByHashData* loadFileByHashData = netData->calldata;
 
     if (netData->type == net_get_done)
     {
-        tic_fs_saveroot(loadFileByHashData->fs, loadFileByHashData->cachePath, netData->done.data, netData->done.size, false);
+        saveCachedCart(loadFileByHashData->fs, loadFileByHashData->cachePath, netData->done.data, netData->done.size);
         loadFileByHashData->done(netData->done.data, netData->done.size, loadFileByHashData->data);
     }
 
@@ -789,6 +1855,8 @@ static void fileByHashLoaded(const net_get_data* netData)
     }
 }
 
+#endif
+
 void tic_fs_hashload(tic_fs* fs, const char* name, const char* hash, fs_load_callback callback, void* data)
 {
 #if defined(BAREMETALPI)
@@ -801,10 +1869,11 @@ void tic_fs_hashload(tic_fs* fs, const char* name, const char* hash, fs_load_cal
 
     {
         s32 size = 0;
-        void* buffer = tic_fs_loadroot(fs, cachePath, &size);
+        void* buffer = loadCachedCart(fs, cachePath, &size);
         if (buffer)
         {
             callback(buffer, size, data);
+            free(buffer);
             return;
         }
     }
@@ -901,6 +1970,20 @@ void* tic_fs_load(tic_fs* fs, const char* name, s32* size)
 #endif
 }
 
+bool tic_fs_view(tic_fs* fs, const char* name, fs_view* view)
+{
+#if defined(BAREMETALPI)
+    s32 size = 0;
+    void* data = tic_fs_load(fs, name, &size);
+
+    *view = (fs_view){data, data ? size : 0, false};
+
+    return data != NULL;
+#else
+    return fs_view_open(tic_fs_path(fs, name), view);
+#endif
+}
+
 void* tic_fs_loadroot(tic_fs* fs, const char* name, s32* size)
 {
     return fs_read(tic_fs_pathroot(fs, name), size);
@@ -927,6 +2010,7 @@ bool tic_fs_makedir(tic_fs* fs, const char* name)
     free(path);
     return (res != FR_OK);
 #else
+    clearListings(fs);
 
     const FsString* pathString = utf8ToString(tic_fs_path(fs, name));
     int result = tic_mkdir(pathString);
@@ -966,5 +2050,36 @@ tic_fs* tic_fs_create(const char* path, tic_net* net)
 
     fs->net = net;
 
+#if defined(FS_ASYNC_ENUM)
+    openStore(fs);
+#endif
+
     return fs;
 }
+
+void tic_fs_delete(tic_fs* fs)
+{
+#if !defined(BAREMETALPI)
+    clearListings(fs);
+
+#if defined(FS_ASYNC_ENUM)
+    closeStore(fs);
+#endif
+
+    if(fs->store)
+        tic_store_delete(fs->store);
+#endif
+
+#if defined(FS_ASYNC_ENUM)
+    // running scans finish on their own and skip the callbacks
+    for(FsScan* scan = fs->scans; scan; scan = scan->next)
+    {
+        uv_mutex_lock(&scan->mutex);
+        scan->fs = NULL;
+        scan->stopped = true;
+        uv_mutex_unlock(&scan->mutex);
+    }
+#endif
+
+    free(fs);
+}
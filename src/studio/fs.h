@@ -33,7 +33,16 @@ typedef void(*fs_load_callback)(const u8* buffer, s32 size, void* data);
 typedef struct tic_fs tic_fs;
 struct tic_net;
 
+// read-only contents of a whole file, mapped into memory where possible
+typedef struct
+{
+    const u8* data;
+    s32 size;
+    bool mapped;
+} fs_view;
+
 tic_fs*     tic_fs_create   (const char* path, struct tic_net* net);
+void        tic_fs_delete   (tic_fs* fs);
 const char* tic_fs_path     (tic_fs* fs, const char* name);
 const char* tic_fs_pathroot (tic_fs* fs, const char* name);
 
@@ -46,6 +55,7 @@ bool    tic_fs_save         (tic_fs* fs, const char* name, const void* data, s32
 bool    tic_fs_saveroot     (tic_fs* fs, const char* name, const void* data, s32 size, bool overwrite);
 void*   tic_fs_load         (tic_fs* fs, const char* name, s32* size);
 void*   tic_fs_loadroot     (tic_fs* fs, const char* name, s32* size);
+bool    tic_fs_view         (tic_fs* fs, const char* name, fs_view* view);
 bool    tic_fs_makedir      (tic_fs* fs, const char* name);
 bool    tic_fs_exists       (tic_fs* fs, const char* name);
 void    tic_fs_openfolder   (tic_fs* fs);
@@ -59,4 +69,27 @@ void    tic_fs_homedir      (tic_fs* fs);
 u64     fs_date     (const char* name);
 bool    fs_exists   (const char* name);
 void*   fs_read     (const char* path, s32* size);
+bool    fs_view_open    (const char* path, fs_view* view);
+void    fs_view_close   (fs_view* view);
 bool    fs_write    (const char* path, const void* data, s32 size);
+
+// writes a temp file and renames it over the target, so the file is never left half written
+bool    fs_replace  (const char* path, const void* data, s32 size);
+bool    fs_remove   (const char* path);
+
+// sets the modification time to now
+void    fs_touch    (const char* path);
+
+// calls back for the regular files in the dir with the extension, or all of them for NULL
+typedef bool(*fs_file_callback)(const char* name, s64 size, u64 date, void* data);
+void    fs_files    (const char* dir, const char* ext, fs_file_callback callback, void* data);
+
+// removes the oldest files with the extension until the rest fit the limit
+void    fs_trim     (const char* dir, const char* ext, s64 limit);
+
+// file written in chunks
+typedef struct fs_file fs_file;
+
+fs_file*    fs_file_create  (const char* path);
+bool        fs_file_write   (fs_file* file, const void* data, s32 size);
+void        fs_file_close   (fs_file* file);
@@ -125,6 +125,9 @@ void tic_net_get(tic_net* net, const char* path, net_get_callback callback, void
 void tic_net_start(tic_net *net) {}
 void tic_net_end(tic_net *net) {}
 
+// responses are cached by the browser
+void tic_net_cache(tic_net* net, const char* dir, s32 limit) {}
+
 tic_net* tic_net_create(const char* host)
 {
     tic_net* net = (tic_net*)malloc(sizeof(tic_net));
@@ -367,6 +370,8 @@ void tic_net_end(tic_net *net)
     LightLock_Unlock(&net->tick_lock);
 }
 
+void tic_net_cache(tic_net* net, const char* dir, s32 limit) {}
+
 #elif defined(BAREMETALPI)
 
 tic_net* tic_net_create(const char* host) {return NULL;}
@@ -374,78 +379,416 @@ void tic_net_get(tic_net* net, const char* url, net_get_callback callback, void*
 void tic_net_close(tic_net* net) {}
 void tic_net_start(tic_net *net) {}
 void tic_net_end(tic_net *net) {}
+void tic_net_cache(tic_net* net, const char* dir, s32 limit) {}
 
 #elif defined(USE_LIBUV)
 
 #include "defines.h"
 
+#include "fs.h"
+
 #include <uv.h>
 #include <http_parser.h>
+#include <ctype.h>
+#include <time.h>
+
+// max number of simultaneous connections, the rest of requests wait in the queue
+#define NET_CONNECTIONS 4
+
+// resolved host address is reused for 5 minutes
+#define NET_DNS_TTL (5 * 60 * 1000)
+
+// response buffer is preallocated by Content-Length up to this size
+#define NET_PREALLOC_MAX (16 * 1024 * 1024)
 
+#define NET_CACHE_EXT ".http"
+
+// cached response file starts with the validators, the body goes next
 typedef struct
 {
-    const char* host;
-    const char* path;
+    char etag[128];
+    char modified[64];
+} NetCacheHeader;
+
+typedef struct
+{
+    u64 key;
+    s32 size;
+    u64 used;
+} NetCacheEntry;
+
+typedef struct NetRequest NetRequest;
+
+struct NetRequest
+{
+    char* path;
 
     net_get_callback callback;
     void* calldata;
 
-    uv_tcp_t tcp;
-    http_parser parser;
-
     struct
     {
         u8* data;
         s32 size;
+        s32 capacity;
         s32 total;
     } content;
 
-} NetRequest;
+    // cached response, the header goes first
+    struct
+    {
+        u8* data;
+        s32 size;
+    } cached;
+
+    NetCacheHeader validators;
+
+    // header being parsed
+    struct
+    {
+        char name[16];
+        s32 size;
+        bool value;
+        char* target;
+        s32 capacity;
+    } header;
+
+    NetRequest* next;
+};
+
+typedef struct
+{
+    NetRequest* first;
+    NetRequest* last;
+} NetQueue;
+
+typedef struct
+{
+    tic_net* net;
+
+    uv_tcp_t tcp;
+    http_parser parser;
+
+    NetRequest* req;
+
+    bool idle;
+    bool reused;
+    bool received;
+    bool complete;
+    bool closing;
+} NetConnection;
+
+typedef struct
+{
+    uv_write_t write;
+    char header[];
+} NetWrite;
 
 struct tic_net
 {
-    const char* host;
+    const char* authority;
+    char host[URL_SIZE];
+    char port[8];
+
+    struct
+    {
+        struct sockaddr_storage addr;
+        u64 expires;
+        bool resolved;
+        uv_getaddrinfo_t* resolver;
+    } dns;
+
+    NetConnection* connections[NET_CONNECTIONS];
+
+    NetQueue queue;
+
+    struct
+    {
+        char* dir;
+        s32 limit;
+        s64 size;
+
+        NetCacheEntry* entries;
+        s32 count;
+        s32 capacity;
+    } cache;
 };
 
-static s32 onBody(http_parser* parser, const char *at, size_t length)
+static void dispatch(tic_net* net);
+
+static void pushRequest(NetQueue* queue, NetRequest* req)
 {
-    NetRequest* req = parser->data;
+    req->next = NULL;
 
-    req->content.data = realloc(req->content.data, req->content.size + length);
-    memcpy(req->content.data + req->content.size, at, length);
+    if(queue->last)
+        queue->last->next = req;
+    else queue->first = req;
 
-    req->content.size += length;
+    queue->last = req;
+}
 
-    req->callback(&(net_get_data) 
+static void unshiftRequest(NetQueue* queue, NetRequest* req)
+{
+    req->next = queue->first;
+    queue->first = req;
+
+    if(!queue->last)
+        queue->last = req;
+}
+
+static NetRequest* shiftRequest(NetQueue* queue)
+{
+    NetRequest* req = queue->first;
+
+    if(req && !(queue->first = req->next))
+        queue->last = NULL;
+
+    return req;
+}
+
+static void freeRequest(NetRequest* req)
+{
+    FREE(req->content.data);
+    FREE(req->cached.data);
+    free(req->path);
+    free(req);
+}
+
+static void failRequest(NetRequest* req, s32 code)
+{
+    req->callback(&(net_get_data)
     {
-        .calldata = req->calldata, 
-        .type = net_get_progress, 
-        .progress = {req->content.size, req->content.total}, 
+        .calldata = req->calldata,
+        .type = net_get_error,
+        .error = { .code = code },
         .url = req->path
     });
 
-    return 0;
+    freeRequest(req);
 }
 
-static void onClose(uv_handle_t* handle)
+// carts and covers are kept on disk by the callers, in the chunk store and the cover files
+static bool keptByCaller(const char* path)
 {
-    NetRequest* req = handle->data;
-    FREE(req->content.data);
-    free((void*)req->path);
-    free(req);
+    static const char Cart[] = "/cart/";
+    return strncmp(path, Cart, sizeof Cart - 1) == 0;
 }
 
-static void freeRequest(NetRequest* req)
+static u64 cacheKey(const char* path)
+{
+    // 64-bit FNV-1a
+    u64 hash = 0xcbf29ce484222325ull;
+
+    for(const u8* ptr = (const u8*)path; *ptr; ptr++)
+        hash = (hash ^ *ptr) * 0x100000001b3ull;
+
+    return hash;
+}
+
+static void cachePath(tic_net* net, u64 key, char* path, s32 size)
 {
-    uv_close((uv_handle_t*)&req->tcp, onClose);
+    snprintf(path, size, "%s%016llx" NET_CACHE_EXT, net->cache.dir, (unsigned long long)key);
 }
 
-static s32 onMessageComplete(http_parser* parser)
+static NetCacheEntry* findEntry(tic_net* net, u64 key)
+{
+    for(NetCacheEntry *entry = net->cache.entries, *end = entry + net->cache.count; entry != end; entry++)
+        if(entry->key == key)
+            return entry;
+
+    return NULL;
+}
+
+static void setEntry(tic_net* net, u64 key, s32 size, u64 used)
+{
+    NetCacheEntry* entry = findEntry(net, key);
+
+    if(!entry)
+    {
+        if(net->cache.count == net->cache.capacity)
+        {
+            net->cache.capacity = net->cache.capacity ? net->cache.capacity * 2 : 64;
+            net->cache.entries = realloc(net->cache.entries, net->cache.capacity * sizeof(NetCacheEntry));
+        }
+
+        entry = &net->cache.entries[net->cache.count++];
+        *entry = (NetCacheEntry){.key = key};
+    }
+
+    net->cache.size += size - entry->size;
+    entry->size = size;
+    entry->used = used;
+}
+
+// marks the entry as recently used, the file time keeps it between sessions
+static void touchEntry(tic_net* net, u64 key)
+{
+    NetCacheEntry* entry = findEntry(net, key);
+
+    if(entry)
+    {
+        entry->used = time(NULL);
+
+        char path[URL_SIZE];
+        cachePath(net, key, path, sizeof path);
+
+        uv_fs_t req;
+        uv_fs_utime(NULL, &req, path, (double)entry->used, (double)entry->used, NULL);
+        uv_fs_req_cleanup(&req);
+    }
+}
+
+// removes the least recently used responses until the cache fits the limit
+static void evictEntries(tic_net* net)
+{
+    while(net->cache.size > net->cache.limit && net->cache.count)
+    {
+        NetCacheEntry* oldest = net->cache.entries;
+
+        for(NetCacheEntry *entry = oldest, *end = entry + net->cache.count; entry != end; entry++)
+            if(entry->used < oldest->used)
+                oldest = entry;
+
+        char path[URL_SIZE];
+        cachePath(net, oldest->key, path, sizeof path);
+
+        uv_fs_t req;
+        uv_fs_unlink(NULL, &req, path, NULL);
+        uv_fs_req_cleanup(&req);
+
+        net->cache.size -= oldest->size;
+        *oldest = net->cache.entries[--net->cache.count];
+    }
+}
+
+static void loadCached(tic_net* net, NetRequest* req)
 {
-    NetRequest* req = parser->data;
+    char path[URL_SIZE];
+    cachePath(net, cacheKey(req->path), path, sizeof path);
+
+    s32 size = 0;
+    u8* data = fs_read(path, &size);
 
-    if (parser->status_code == HTTP_STATUS_OK)
+    if(data && size >= (s32)sizeof(NetCacheHeader))
     {
+        req->cached.data = data;
+        req->cached.size = size;
+    }
+    else FREE(data);
+}
+
+static void storeResponse(tic_net* net, NetRequest* req)
+{
+    s32 size = sizeof(NetCacheHeader) + req->content.size;
+
+    if(!net->cache.dir || size > net->cache.limit || keptByCaller(req->path))
+        return;
+
+    // a response without validators would be downloaded again anyway
+    if(!*req->validators.etag && !*req->validators.modified)
+        return;
+
+    u8* data = malloc(size);
+    memcpy(data, &req->validators, sizeof(NetCacheHeader));
+
+    if(req->content.size)
+        memcpy(data + sizeof(NetCacheHeader), req->content.data, req->content.size);
+
+    u64 key = cacheKey(req->path);
+
+    char path[URL_SIZE];
+    cachePath(net, key, path, sizeof path);
+
+    if(fs_replace(path, data, size))
+    {
+        setEntry(net, key, size, time(NULL));
+        evictEntries(net);
+    }
+
+    free(data);
+}
+
+static void doneCached(tic_net* net, NetRequest* req)
+{
+    touchEntry(net, cacheKey(req->path));
+
+    req->callback(&(net_get_data)
+    {
+        .calldata = req->calldata,
+        .type = net_get_done,
+        .done = 
+        { 
+            .data = req->cached.data + sizeof(NetCacheHeader), 
+            .size = req->cached.size - sizeof(NetCacheHeader),
+        },
+        .url = req->path
+    });
+
+    freeRequest(req);
+}
+
+static void onConnectionClosed(uv_handle_t* handle)
+{
+    free(handle->data);
+}
+
+static void closeConnection(NetConnection* conn)
+{
+    if(conn->closing)
+        return;
+
+    conn->closing = true;
+
+    if(conn->net)
+        for(s32 i = 0; i < NET_CONNECTIONS; i++)
+            if(conn->net->connections[i] == conn)
+                conn->net->connections[i] = NULL;
+
+    uv_close((uv_handle_t*)&conn->tcp, onConnectionClosed);
+}
+
+static void onConnectionLost(NetConnection* conn, s32 code)
+{
+    if(conn->closing)
+        return;
+
+    tic_net* net = conn->net;
+    NetRequest* req = conn->req;
+    conn->req = NULL;
+
+    closeConnection(conn);
+
+    if(req)
+    {
+        // the server closed a kept alive connection before it got the request, 
+        // try again, every retry drops one of the reused connections
+        if(conn->reused && !conn->received)
+            unshiftRequest(&net->queue, req);
+        else failRequest(req, code);
+    }
+
+    dispatch(net);
+}
+
+static void completeRequest(NetConnection* conn, bool keepAlive)
+{
+    tic_net* net = conn->net;
+    NetRequest* req = conn->req;
+    conn->req = NULL;
+
+    if(keepAlive)
+    {
+        conn->idle = true;
+        conn->reused = true;
+    }
+    else closeConnection(conn);
+
+    if (conn->parser.status_code == HTTP_STATUS_NOT_MODIFIED && req->cached.data)
+        doneCached(net, req);
+    else if (conn->parser.status_code == HTTP_STATUS_OK)
+    {
+        storeResponse(net, req);
+
         req->callback(&(net_get_data)
         {
             .calldata = req->calldata,
@@ -453,46 +796,137 @@ static s32 onMessageComplete(http_parser* parser)
             .done = { .data = req->content.data, .size = req->content.size },
             .url = req->path
         });
+
+        freeRequest(req);
     }
+    else failRequest(req, conn->parser.status_code);
 
-    freeRequest(req);
+    dispatch(net);
+}
+
+static s32 onBody(http_parser* parser, const char *at, size_t length)
+{
+    NetConnection* conn = parser->data;
+    NetRequest* req = conn->req;
+
+    // the body of an error response is skipped to keep the connection
+    if (parser->status_code != HTTP_STATUS_OK)
+        return 0;
+
+    if(req->content.size + (s32)length > req->content.capacity)
+    {
+        req->content.capacity = MAX(req->content.capacity * 2, req->content.size + (s32)length);
+        req->content.data = realloc(req->content.data, req->content.capacity);
+    }
+
+    memcpy(req->content.data + req->content.size, at, length);
+    req->content.size += length;
+
+    req->callback(&(net_get_data) 
+    {
+        .calldata = req->calldata, 
+        .type = net_get_progress, 
+        .progress = {req->content.size, req->content.total}, 
+        .url = req->path
+    });
 
     return 0;
 }
 
 static s32 onHeadersComplete(http_parser* parser)
 {
-    NetRequest* req = parser->data;
-
-    bool hasBody = parser->flags & F_CHUNKED || (parser->content_length > 0 && parser->content_length != ULLONG_MAX);
+    NetConnection* conn = parser->data;
+    NetRequest* req = conn->req;
 
+    FREE(req->content.data);
     ZEROMEM(req->content);
-    req->content.total = parser->content_length;
 
     // !TODO: handle HTTP_STATUS_MOVED_PERMANENTLY here
-    if (!hasBody || parser->status_code != HTTP_STATUS_OK)
-        return 1;
+    if (parser->status_code == HTTP_STATUS_OK 
+        && parser->content_length > 0 
+        && parser->content_length != ULLONG_MAX)
+    {
+        req->content.total = parser->content_length;
+
+        if(parser->content_length <= NET_PREALLOC_MAX)
+            req->content.data = malloc(req->content.capacity = req->content.total);
+    }
 
     return 0;
 }
 
-static s32 onStatus(http_parser* parser, const char* at, size_t length)
+static bool isHeader(const char* name, const char* expected)
 {
-    return parser->status_code != HTTP_STATUS_OK;
+    while(*name && tolower(*name) == tolower(*expected))
+        name++, expected++;
+
+    return *name == *expected;
 }
 
-static void onError(NetRequest* req, s32 code)
+static s32 onHeaderField(http_parser* parser, const char *at, size_t length)
 {
-    req->callback(&(net_get_data)
+    NetConnection* conn = parser->data;
+    NetRequest* req = conn->req;
+
+    if(req->header.value)
+        ZEROMEM(req->header);
+
+    s32 size = MIN((s32)length, (s32)sizeof req->header.name - 1 - req->header.size);
+    memcpy(req->header.name + req->header.size, at, size);
+    req->header.name[req->header.size += size] = '\0';
+
+    return 0;
+}
+
+static s32 onHeaderValue(http_parser* parser, const char *at, size_t length)
+{
+    NetConnection* conn = parser->data;
+    NetRequest* req = conn->req;
+
+    if(!req->header.value)
     {
-        .calldata = req->calldata,
-        .type = net_get_error,
-        .error = { .code = code }
-    });
+        req->header.value = true;
 
-    freeRequest(req);
+        if(isHeader(req->header.name, "ETag"))
+            req->header.target = req->validators.etag, req->header.capacity = sizeof req->validators.etag;
+        else if(isHeader(req->header.name, "Last-Modified"))
+            req->header.target = req->validators.modified, req->header.capacity = sizeof req->validators.modified;
+    }
+
+    if(req->header.target)
+    {
+        s32 size = (s32)strlen(req->header.target);
+
+        // a cut validator is useless
+        if(size + (s32)length < req->header.capacity)
+            memcpy(req->header.target + size, at, length);
+        else
+        {
+            *req->header.target = '\0';
+            req->header.target = NULL;
+        }
+    }
+
+    return 0;
+}
+
+static s32 onMessageComplete(http_parser* parser)
+{
+    NetConnection* conn = parser->data;
+    conn->complete = true;
+
+    return 0;
 }
 
+static const http_parser_settings ParserSettings = 
+{
+    .on_header_field = onHeaderField,
+    .on_header_value = onHeaderValue,
+    .on_body = onBody,
+    .on_message_complete = onMessageComplete,
+    .on_headers_complete = onHeadersComplete,
+};
+
 static void allocBuffer(uv_handle_t *handle, size_t size, uv_buf_t *buf)
 {
     buf->base = malloc(size);
@@ -501,82 +935,234 @@ static void allocBuffer(uv_handle_t *handle, size_t size, uv_buf_t *buf)
 
 static void onResponse(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) 
 {
-    NetRequest* req = stream->data;
+    NetConnection* conn = stream->data;
 
-    if(nread > 0)
+    if(nread > 0 && conn->req)
     {
-        static const http_parser_settings ParserSettings = 
-        {
-            .on_status = onStatus,
-            .on_body = onBody,
-            .on_message_complete = onMessageComplete,
-            .on_headers_complete = onHeadersComplete,
-        };
+        conn->received = true;
 
-        s32 parsed = http_parser_execute(&req->parser, &ParserSettings, buf->base, nread);
+        s32 parsed = http_parser_execute(&conn->parser, &ParserSettings, buf->base, nread);
 
-        if(parsed != nread)
-            onError(req, req->parser.status_code);
+        if(conn->complete)
+            completeRequest(conn, parsed == nread && http_should_keep_alive(&conn->parser));
+        else if(parsed != nread)
+            onConnectionLost(conn, conn->parser.status_code);
+    }
+    else if(nread == UV_EOF && conn->req && conn->received)
+    {
+        // the response without length ends with the connection
+        http_parser_execute(&conn->parser, &ParserSettings, NULL, 0);
 
-        free(buf->base);
+        if(conn->complete)
+            completeRequest(conn, false);
+        else onConnectionLost(conn, conn->parser.status_code);
     }
-    else onError(req, 0);
+    else if(nread != 0)
+        onConnectionLost(conn, 0);
+
+    free(buf->base);
 }
 
-static void onHeaderSent(uv_write_t *write, s32 status)
+static void onRequestSent(uv_write_t *write, s32 status)
 {
-    NetRequest* req = write->data;
-    http_parser_init(&req->parser, HTTP_RESPONSE);
-    req->parser.data = req;
-
-    uv_stream_t* handle = write->handle;
+    NetConnection* conn = write->data;
     free(write);
 
-    handle->data = req;
-    uv_read_start(handle, allocBuffer, onResponse);
+    if(status < 0 && status != UV_ECANCELED)
+        onConnectionLost(conn, 0);
 }
 
-static void onConnect(uv_connect_t *con, s32 status)
+static void sendRequest(NetConnection* conn, NetRequest* req)
 {
-    NetRequest* req = con->data;
+    static const char Format[] = "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n%s\r\n";
+
+    tic_net* net = conn->net;
+
+    conn->req = req;
+    conn->idle = conn->received = conn->complete = false;
+
+    ZEROMEM(req->validators);
+    ZEROMEM(req->header);
 
-    char httpReq[2048];
-    snprintf(httpReq, sizeof httpReq, "GET %s HTTP/1.1\nHost: %s\n\n", req->path, req->host);
+    // revalidate the cached response
+    char conditions[sizeof(NetCacheHeader) + 64] = "";
+
+    if(req->cached.data)
+    {
+        const NetCacheHeader* cached = (const NetCacheHeader*)req->cached.data;
+        s32 size = 0;
+
+        if(*cached->etag)
+            size += snprintf(conditions + size, sizeof conditions - size, "If-None-Match: %.*s\r\n", 
+                (s32)sizeof cached->etag, cached->etag);
+
+        if(*cached->modified)
+            snprintf(conditions + size, sizeof conditions - size, "If-Modified-Since: %.*s\r\n", 
+                (s32)sizeof cached->modified, cached->modified);
+    }
 
-    uv_buf_t http = uv_buf_init(httpReq, strlen(httpReq));
-    uv_write(MOVE((uv_write_t){.data = req}), con->handle, &http, 1, onHeaderSent);
+    http_parser_init(&conn->parser, HTTP_RESPONSE);
+    conn->parser.data = conn;
 
+    s32 size = snprintf(NULL, 0, Format, req->path, net->authority, conditions);
+    NetWrite* write = malloc(sizeof(NetWrite) + size + 1);
+    snprintf(write->header, size + 1, Format, req->path, net->authority, conditions);
+    write->write.data = conn;
+
+    uv_buf_t http = uv_buf_init(write->header, size);
+
+    if(uv_write(&write->write, (uv_stream_t*)&conn->tcp, &http, 1, onRequestSent) < 0)
+    {
+        free(write);
+        onConnectionLost(conn, 0);
+    }
+}
+
+static void onConnect(uv_connect_t *con, s32 status)
+{
+    NetConnection* conn = con->data;
     free(con);
+
+    if(status == UV_ECANCELED)
+        return;
+
+    if(status < 0)
+    {
+        // the address could be stale, resolve it again
+        conn->net->dns.resolved = false;
+        onConnectionLost(conn, 0);
+        return;
+    }
+
+    uv_read_start((uv_stream_t*)&conn->tcp, allocBuffer, onResponse);
+    sendRequest(conn, conn->req);
+}
+
+static void openConnection(tic_net* net, NetConnection** slot, NetRequest* req)
+{
+    NetConnection* conn = *slot = NEW(NetConnection);
+
+    *conn = (NetConnection)
+    {
+        .net = net,
+        .req = req,
+    };
+
+    uv_tcp_init(uv_default_loop(), &conn->tcp);
+    uv_tcp_nodelay(&conn->tcp, 1);
+    conn->tcp.data = conn;
+
+    uv_connect_t* con = MOVE((uv_connect_t){.data = conn});
+
+    if(uv_tcp_connect(con, &conn->tcp, (const struct sockaddr*)&net->dns.addr, onConnect) < 0)
+    {
+        free(con);
+        onConnectionLost(conn, 0);
+    }
 }
 
 static void onResolved(uv_getaddrinfo_t *resolver, s32 status, struct addrinfo *res)
 {
-    NetRequest* req = resolver->data;
+    tic_net* net = resolver->data;
+    free(resolver);
 
-    if (res)
+    if(net)
     {
-        uv_tcp_connect(MOVE((uv_connect_t){.data = req}), &req->tcp, res->ai_addr, onConnect);
+        net->dns.resolver = NULL;
+
+        if (res)
+        {
+            memcpy(&net->dns.addr, res->ai_addr, res->ai_addrlen);
+            net->dns.expires = uv_now(uv_default_loop()) + NET_DNS_TTL;
+            net->dns.resolved = true;
+
+            dispatch(net);
+        }
+        else
+        {
+            for(NetRequest* req; (req = shiftRequest(&net->queue));)
+                failRequest(req, 0);
+        }
+    }
+
+    if(res)
         uv_freeaddrinfo(res);
+}
+
+static void resolve(tic_net* net)
+{
+    if(net->dns.resolver)
+        return;
+
+    static const struct addrinfo Hints = 
+    {
+        .ai_family = AF_UNSPEC,
+        .ai_socktype = SOCK_STREAM,
+    };
+
+    net->dns.resolver = MOVE((uv_getaddrinfo_t){.data = net});
+
+    if(uv_getaddrinfo(uv_default_loop(), net->dns.resolver, onResolved, net->host, net->port, &Hints) < 0)
+    {
+        free(net->dns.resolver);
+        net->dns.resolver = NULL;
+
+        for(NetRequest* req; (req = shiftRequest(&net->queue));)
+            failRequest(req, 0);
     }
-    else onError(req, 0);
+}
 
-    free(resolver);
+// sends queued requests through idle connections or opens new ones while the limit allows
+static void dispatch(tic_net* net)
+{
+    while(net->queue.first)
+    {
+        NetConnection* idle = NULL;
+        NetConnection** slot = NULL;
+
+        for(s32 i = 0; i < NET_CONNECTIONS && !idle; i++)
+        {
+            NetConnection* conn = net->connections[i];
+
+            if(!conn)
+            {
+                if(!slot)
+                    slot = &net->connections[i];
+            }
+            else if(conn->idle)
+                idle = conn;
+        }
+
+        if(idle)
+            sendRequest(idle, shiftRequest(&net->queue));
+        else if(slot)
+        {
+            if(!net->dns.resolved || uv_now(uv_default_loop()) >= net->dns.expires)
+            {
+                resolve(net);
+                break;
+            }
+
+            openConnection(net, slot, shiftRequest(&net->queue));
+        }
+        else break;
+    }
 }
 
 void tic_net_get(tic_net* net, const char* path, net_get_callback callback, void* calldata)
 {
-    uv_loop_t* loop = uv_default_loop();
-
     NetRequest* req = MOVE((NetRequest)
     {
-        .host = net->host,
         .callback = callback,
         .calldata = calldata,
         .path = strdup(path),
     });
 
-    uv_tcp_init(loop, &req->tcp);
-    uv_getaddrinfo(loop, MOVE((uv_getaddrinfo_t){.data = req}), onResolved, net->host, "80", NULL);
+    if(net->cache.dir && !keptByCaller(path))
+        loadCached(net, req);
+
+    pushRequest(&net->queue, req);
+    dispatch(net);
 }
 
 void tic_net_start(tic_net *net) {}
@@ -586,22 +1172,96 @@ void tic_net_end(tic_net *net)
     uv_run(uv_default_loop(), UV_RUN_NOWAIT);
 }
 
+void tic_net_cache(tic_net* net, const char* dir, s32 limit)
+{
+    FREE(net->cache.dir);
+    net->cache.dir = strdup(dir);
+    net->cache.limit = limit;
+
+    uv_fs_t req;
+    uv_fs_mkdir(NULL, &req, dir, 0700, NULL);
+    uv_fs_req_cleanup(&req);
+
+    // index the responses cached by the previous sessions
+    if(uv_fs_scandir(NULL, &req, dir, 0, NULL) >= 0)
+    {
+        static const char Ext[] = NET_CACHE_EXT;
+        enum {KeySize = 16};
+
+        for(uv_dirent_t ent; uv_fs_scandir_next(&req, &ent) != UV_EOF;)
+        {
+            if(strlen(ent.name) != KeySize + sizeof Ext - 1 || strcmp(ent.name + KeySize, Ext) != 0)
+                continue;
+
+            char path[URL_SIZE];
+            snprintf(path, sizeof path, "%s%s", dir, ent.name);
+
+            uv_fs_t stat;
+
+            if(uv_fs_stat(NULL, &stat, path, NULL) == 0)
+                setEntry(net, strtoull(ent.name, NULL, 16), (s32)stat.statbuf.st_size, stat.statbuf.st_mtim.tv_sec);
+
+            uv_fs_req_cleanup(&stat);
+        }
+    }
+
+    uv_fs_req_cleanup(&req);
+
+    evictEntries(net);
+}
+
 tic_net* tic_net_create(const char* host)
 {
     tic_net* net = NEW(tic_net);
     memset(net, 0, sizeof(tic_net));
 
-    net->host = host;
-
     static const char Http[] = "http://";
     if(strstr(host, Http) == host)
-        net->host += sizeof Http - 1;
+        host += sizeof Http - 1;
+
+    net->authority = host;
+
+    // optional port goes after the host name
+    strncpy(net->host, host, sizeof net->host - 1);
+    strcpy(net->port, "80");
+
+    char* port = strchr(net->host, ':');
+
+    if(port)
+    {
+        *port++ = '\0';
+        strncpy(net->port, port, sizeof net->port - 1);
+    }
 
     return net;
 }
 
 void tic_net_close(tic_net* net)
 {
+    for(s32 i = 0; i < NET_CONNECTIONS; i++)
+    {
+        NetConnection* conn = net->connections[i];
+
+        if(conn)
+        {
+            if(conn->req)
+                freeRequest(conn->req);
+
+            conn->req = NULL;
+            closeConnection(conn);
+            conn->net = NULL;
+        }
+    }
+
+    for(NetRequest* req; (req = shiftRequest(&net->queue));)
+        freeRequest(req);
+
+    if(net->dns.resolver)
+        net->dns.resolver->data = NULL;
+
+    FREE(net->cache.entries);
+    FREE(net->cache.dir);
+
     free(net);
 }
 
@@ -68,3 +68,6 @@ void tic_net_get(tic_net* net, const char* url, net_get_callback callback, void*
 void tic_net_close(tic_net* net);
 void tic_net_start(tic_net *net);
 void tic_net_end(tic_net *net);
+
+// keeps responses in `dir` up to `limit` bytes, revalidated with ETag/Last-Modified
+void tic_net_cache(tic_net* net, const char* dir, s32 limit);
@@ -49,21 +49,20 @@ static void makeTag(const char* tag, char* out, s32 bank)
     else strcpy(out, tag);
 }
 
-static void buf2str(const void* data, s32 size, char* ptr, bool flip)
+static char* buf2str(const void* data, s32 size, char* ptr, bool flip)
 {
-    enum {Len = 2};
+    static const char Hex[] = "0123456789abcdef";
 
-    for(s32 i = 0; i < size; i++, ptr+=Len)
-    {
-        sprintf(ptr, "%02x", ((u8*)data)[i]);
+    const u8* src = data;
+    const s32 hi = flip ? 1 : 0, lo = flip ? 0 : 1;
 
-        if(flip)
-        {
-            char tmp = ptr[0];
-            ptr[0] = ptr[1];
-            ptr[1] = tmp;
-        }
+    for(s32 i = 0; i < size; i++, ptr += 2)
+    {
+        ptr[hi] = Hex[src[i] >> 4];
+        ptr[lo] = Hex[src[i] & 0xf];
     }
+
+    return ptr;
 }
 
 static bool bufferEmpty(const u8* data, s32 size)
@@ -80,8 +79,10 @@ static char* saveTextSection(char* ptr, const char* data)
     if(data[0] == '\0')
         return ptr;
 
-    sprintf(ptr, "%s\n", data);
-    ptr += strlen(ptr);
+    size_t size = strlen(data);
+    memcpy(ptr, data, size);
+    ptr += size;
+    *ptr++ = '\n';
 
     return ptr;
 }
@@ -91,14 +92,9 @@ static char* saveBinaryBuffer(char* ptr, const char* comment, const void* data,
     if(bufferEmpty(data, size)) 
         return ptr;
 
-    sprintf(ptr, "%s %03i:", comment, row);
-    ptr += strlen(ptr);
-
-    buf2str(data, size, ptr, flip);
-    ptr += strlen(ptr);
-
-    sprintf(ptr, "\n");
-    ptr += strlen(ptr);
+    ptr += sprintf(ptr, "%s %03i:", comment, row);
+    ptr = buf2str(data, size, ptr, flip);
+    *ptr++ = '\n';
 
     return ptr;
 }
@@ -108,14 +104,12 @@ static char* saveBinarySection(char* ptr, const char* comment, const char* tag,
     if(bufferEmpty(data, size * count)) 
         return ptr;
 
-    sprintf(ptr, "%s <%s>\n", comment, tag);
-    ptr += strlen(ptr);
+    ptr += sprintf(ptr, "%s <%s>\n", comment, tag);
 
     for(s32 i = 0; i < count; i++, data = (u8*)data + size)
         ptr = saveBinaryBuffer(ptr, comment, data, size, i, flip);
 
-    sprintf(ptr, "%s </%s>\n\n", comment, tag);
-    ptr += strlen(ptr);
+    ptr += sprintf(ptr, "%s </%s>\n\n", comment, tag);
 
     return ptr;
 }
@@ -147,90 +141,159 @@ s32 tic_project_save(const char* name, void* data, const tic_cartridge* cart)
                 (u8*)&cart->banks[b] + section->offset, section->size, section->flip);
         }
 
-    return (s32)strlen(stream);
+    *ptr = '\0';
+
+    return (s32)(ptr - stream);
 }
 
-static bool loadTextSection(const char* project, const char* comment, char* dst, s32 size)
+typedef struct
 {
-    bool done = false;
+    const char* start;
+    const char* end;
+} SectionRef;
 
-    const char* start = project;
-    const char* end = project + strlen(project);
+typedef struct
+{
+    const char* codeEnd;
+    SectionRef sections[COUNT_OF(BinarySections)][TIC_BANKS];
+} ProjectIndex;
 
-    {
-        char tagstart[16];
-        sprintf(tagstart, "\n%s <", comment);
+static inline const char* getLineEnd(const char* ptr)
+{
+    while(*ptr && isspace(*ptr) && *ptr++ != '\n');
 
-        const char* ptr = strstr(project, tagstart);
+    return ptr;
+}
 
-        if(ptr && ptr < end)
-            end = ptr;
-    }
+// finds the section for a "TAG" or "TAG<bank>" name as made by makeTag
+static SectionRef* findSection(ProjectIndex* index, const char* name, s32 size)
+{
+    s32 len = 0;
+    while(len < size && isalpha(name[len])) len++;
 
-    if(end > start)
+    s32 bank = 0;
+    if(len < size)
     {
-        memcpy(dst, start, MIN(size, end - start));
-        done = true;
+        if(size - len != 1 || name[len] < '1' || name[len] >= '0' + TIC_BANKS)
+            return NULL;
+
+        bank = name[len] - '0';
     }
 
-    return done;
+    for(s32 i = 0; i < COUNT_OF(BinarySections); i++)
+        if(strlen(BinarySections[i].tag) == len && memcmp(BinarySections[i].tag, name, len) == 0)
+            return &index->sections[i][bank];
+
+    return NULL;
 }
 
-static inline const char* getLineEnd(const char* ptr)
+static inline const char* findComment(const char* ptr, const char* comment, s32 size)
 {
-    while(*ptr && isspace(*ptr) && *ptr++ != '\n');
+    for(; *ptr; ptr++)
+        if(*ptr == *comment && strncmp(ptr, comment, size) == 0)
+            return ptr;
 
-    return ptr;
+    return NULL;
 }
 
-static bool loadBinarySection(const char* project, const char* comment, const char* tag, s32 count, void* dst, s32 size, bool flip)
+// collects the code end and all the "<TAG>"..."</TAG>" blocks in one pass
+static void indexProject(ProjectIndex* index, const char* project, const char* comment)
 {
-    char tagbuf[64];
-    sprintf(tagbuf, "%s <%s>", comment, tag);
+    const s32 commentLen = (s32)strlen(comment);
 
-    const char* start = strstr(project, tagbuf);
-    bool done = false;
+    memset(index, 0, sizeof(ProjectIndex));
+    index->codeEnd = project + strlen(project);
 
-    if(start)
+    for(const char* ptr = findComment(project, comment, commentLen); ptr; ptr = findComment(ptr + 1, comment, commentLen))
     {
-        start += strlen(tagbuf);
-        start = getLineEnd(start);
+        const char* tag = ptr + commentLen;
+
+        if(tag[0] != ' ' || tag[1] != '<')
+            continue;
+
+        bool newLine = ptr > project && ptr[-1] == '\n';
+
+        if(newLine && index->codeEnd > ptr - 1)
+            index->codeEnd = ptr - 1;
+
+        const char* name = tag + 2;
+        bool close = *name == '/';
+        if(close) name++;
+
+        const char* nameEnd = name;
+        while(isalnum(*nameEnd)) nameEnd++;
 
-        sprintf(tagbuf, "\n%s </%s>", comment, tag);
-        const char* end = strstr(start, tagbuf);
+        if(*nameEnd != '>')
+            continue;
 
-        if(end > start)
+        SectionRef* section = findSection(index, name, (s32)(nameEnd - name));
+
+        if(!section)
+            continue;
+
+        if(close)
         {
-            const char* ptr = start;
+            if(newLine && section->start && !section->end && ptr - 1 >= section->start)
+                section->end = ptr - 1;
+        }
+        else if(!section->start)
+            section->start = getLineEnd(nameEnd + 1);
+    }
+}
 
-            if(size > 0)
-            {
-                while(ptr < end)
-                {
-                    static char lineStr[] = "999";
-                    memcpy(lineStr, ptr + strlen(comment) + 1, sizeof lineStr - 1);
+static bool loadTextSection(const char* project, const ProjectIndex* index, char* dst, s32 size)
+{
+    bool done = false;
 
-                    s32 index = atoi(lineStr);
-                    
-                    if(index < count)
-                    {
-                        ptr += strlen(comment) + sizeof(" 999:") - 1;
-                        tic_tool_str2buf(ptr, size*2, (u8*)dst + size*index, flip);
-                        ptr += size*2 + 1;
+    const char* start = project;
+    const char* end = index->codeEnd;
 
-                        ptr = getLineEnd(ptr);
-                    }
-                    else break;
-                }               
-            }
-            else
+    if(end > start)
+    {
+        memcpy(dst, start, MIN(size, end - start));
+        done = true;
+    }
+
+    return done;
+}
+
+static bool loadBinarySection(const SectionRef* section, const char* comment, s32 count, void* dst, s32 size, bool flip)
+{
+    const char* start = section->start;
+    const char* end = section->end;
+    bool done = false;
+
+    if(start && end > start)
+    {
+        const char* ptr = start;
+
+        if(size > 0)
+        {
+            while(ptr < end)
             {
-                ptr += strlen(comment) + sizeof(" 999:") - 1;
-                tic_tool_str2buf(ptr, (s32)(end - ptr), (u8*)dst, flip);
-            }
+                char lineStr[] = "999";
+                memcpy(lineStr, ptr + strlen(comment) + 1, sizeof lineStr - 1);
 
-            done = true;
+                s32 index = atoi(lineStr);
+                
+                if(index < count)
+                {
+                    ptr += strlen(comment) + sizeof(" 999:") - 1;
+                    tic_tool_str2buf(ptr, size*2, (u8*)dst + size*index, flip);
+                    ptr += size*2 + 1;
+
+                    ptr = getLineEnd(ptr);
+                }
+                else break;
+            }               
+        }
+        else
+        {
+            ptr += strlen(comment) + sizeof(" 999:") - 1;
+            tic_tool_str2buf(ptr, (s32)(end - ptr), (u8*)dst, flip);
         }
+
+        done = true;
     }
 
     return done;
@@ -258,19 +321,21 @@ bool tic_project_load(const char* name, const char* data, s32 size, tic_cartridg
         if(cart)
         {
             const char* comment = projectComment(name);
-            char tag[16];
+            ProjectIndex index;
+
+            indexProject(&index, project, comment);
 
-            if(loadTextSection(project, comment, cart->code.data, sizeof(tic_code)))
+            if(loadTextSection(project, &index, cart->code.data, sizeof(tic_code)))
                 done = true;
 
             if(done)
             {
-                FOR(const struct BinarySection*, section, BinarySections)
+                for(s32 i = 0; i < COUNT_OF(BinarySections); i++)
                     for(s32 b = 0; b < TIC_BANKS; b++)
                     {
-                        makeTag(section->tag, tag, b);
+                        const struct BinarySection* section = &BinarySections[i];
 
-                        if(loadBinarySection(project, comment, tag, section->count, (u8*)&cart->banks[b] + section->offset, section->size, section->flip))
+                        if(loadBinarySection(&index.sections[i][b], comment, section->count, (u8*)&cart->banks[b] + section->offset, section->size, section->flip))
                             done = true;
                     }
             }
@@ -0,0 +1,203 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "recorder.h"
+#include "tic80.h"
+#include "fs.h"
+#include "ext/gif.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(USE_LIBUV)
+#include <uv.h>
+#endif
+
+// GIF delays are in 1/100s, so 60 fps is recorded at 50 fps with 2/100s delay
+#define GIF_FPS 50
+#define GIF_DELAY (100 / GIF_FPS)
+
+// frames waiting for the encoder
+#define QUEUE_SIZE 8
+
+struct tic_recorder
+{
+    fs_file* file;
+    gif_writer* writer;
+
+    s32 size;
+    s32 frame;
+    bool error;
+
+#if defined(USE_LIBUV)
+    uv_thread_t thread;
+    uv_mutex_t mutex;
+    uv_cond_t cond;
+
+    u8* queue[QUEUE_SIZE];
+    s32 head;
+    s32 count;
+    bool done;
+#endif
+};
+
+static s32 writeFile(void* data, const u8* buffer, s32 size)
+{
+    tic_recorder* recorder = data;
+
+    return fs_file_write(recorder->file, buffer, size) ? size : 0;
+}
+
+#if defined(USE_LIBUV)
+
+static void encodeFrames(void* arg)
+{
+    tic_recorder* recorder = arg;
+
+    uv_mutex_lock(&recorder->mutex);
+
+    while(true)
+    {
+        while(recorder->count == 0 && !recorder->done)
+            uv_cond_wait(&recorder->cond, &recorder->mutex);
+
+        if(recorder->count == 0)
+            break;
+
+        const u8* frame = recorder->queue[recorder->head];
+
+        uv_mutex_unlock(&recorder->mutex);
+        bool done = gif_writer_frame(recorder->writer, frame, GIF_DELAY);
+        uv_mutex_lock(&recorder->mutex);
+
+        if(!done)
+            recorder->error = true;
+
+        recorder->head = (recorder->head + 1) % QUEUE_SIZE;
+        recorder->count--;
+
+        uv_cond_broadcast(&recorder->cond);
+    }
+
+    uv_mutex_unlock(&recorder->mutex);
+}
+
+#endif
+
+tic_recorder* tic_recorder_create(const char* path, s32 width, s32 height, s32 scale)
+{
+    tic_recorder* recorder = calloc(1, sizeof(tic_recorder));
+
+    recorder->size = width * height * sizeof(u32);
+    recorder->file = fs_file_create(path);
+
+    if(recorder->file)
+    {
+        recorder->writer = gif_writer_open(width, height, scale, writeFile, recorder);
+
+        if(recorder->writer)
+        {
+#if defined(USE_LIBUV)
+            for(s32 i = 0; i < QUEUE_SIZE; i++)
+                recorder->queue[i] = malloc(recorder->size);
+
+            uv_mutex_init(&recorder->mutex);
+            uv_cond_init(&recorder->cond);
+
+            if(uv_thread_create(&recorder->thread, encodeFrames, recorder) != 0)
+            {
+                // encode on the caller thread
+                recorder->done = true;
+            }
+#endif
+            return recorder;
+        }
+
+        fs_file_close(recorder->file);
+    }
+
+    free(recorder);
+    return NULL;
+}
+
+bool tic_recorder_frame(tic_recorder* recorder, const u32* pixels)
+{
+    s32 frame = recorder->frame++;
+
+    // drop the frames between GIF_FPS ticks
+    if(frame > 0 && frame * GIF_FPS / TIC80_FRAMERATE == (frame - 1) * GIF_FPS / TIC80_FRAMERATE)
+        return !recorder->error;
+
+#if defined(USE_LIBUV)
+    if(!recorder->done)
+    {
+        uv_mutex_lock(&recorder->mutex);
+
+        while(recorder->count == QUEUE_SIZE)
+            uv_cond_wait(&recorder->cond, &recorder->mutex);
+
+        memcpy(recorder->queue[(recorder->head + recorder->count) % QUEUE_SIZE], pixels, recorder->size);
+        recorder->count++;
+
+        uv_cond_broadcast(&recorder->cond);
+
+        bool error = recorder->error;
+        uv_mutex_unlock(&recorder->mutex);
+
+        return !error;
+    }
+#endif
+
+    if(!gif_writer_frame(recorder->writer, (const u8*)pixels, GIF_DELAY))
+        recorder->error = true;
+
+    return !recorder->error;
+}
+
+bool tic_recorder_close(tic_recorder* recorder)
+{
+#if defined(USE_LIBUV)
+    if(!recorder->done)
+    {
+        uv_mutex_lock(&recorder->mutex);
+        recorder->done = true;
+        uv_cond_broadcast(&recorder->cond);
+        uv_mutex_unlock(&recorder->mutex);
+
+        uv_thread_join(&recorder->thread);
+    }
+
+    uv_cond_destroy(&recorder->cond);
+    uv_mutex_destroy(&recorder->mutex);
+
+    for(s32 i = 0; i < QUEUE_SIZE; i++)
+        free(recorder->queue[i]);
+#endif
+
+    bool done = gif_writer_close(recorder->writer) && !recorder->error;
+
+    fs_file_close(recorder->file);
+    free(recorder);
+
+    return done;
+}
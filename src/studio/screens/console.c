@@ -51,6 +51,10 @@
 
 #include <sys/stat.h>
 
+#if defined(USE_LIBUV)
+#include <uv.h>
+#endif
+
 #if defined(__EMSCRIPTEN__)
 #include <emscripten.h>
 #endif
@@ -731,17 +735,16 @@ static void updateProject(Console* console)
 
     if(*path)
     {
-        s32 size = 0;
-        void* data = fs_read(path, &size);
+        fs_view view;
 
-        if(data) SCOPE(free(data))
+        if(fs_view_open(path, &view)) SCOPE(fs_view_close(&view))
         {
 #if defined(TIC80_PRO)
             if(tic_project_ext(path))
-                tic_project_load(console->rom.name, data, size, &tic->cart);
+                tic_project_load(console->rom.name, (const char*)view.data, view.size, &tic->cart);
             else
 #endif
-                tic_cart_load(&tic->cart, data, size);
+                tic_cart_load(&tic->cart, view.data, view.size);
 
             studioRomLoaded(console->studio);
         }
@@ -882,30 +885,27 @@ static void onLoadCommandConfirmed(Console* console)
         }
         else
         {
-            s32 size = 0;
-            void* data = strcmp(name, CONFIG_TIC_PATH) == 0
-                ? tic_fs_loadroot(console->fs, name, &size)
-                : tic_fs_load(console->fs, name, &size);
+            fs_view view;
+            bool loaded = strcmp(name, CONFIG_TIC_PATH) == 0
+                ? fs_view_open(tic_fs_pathroot(console->fs, name), &view)
+                : tic_fs_view(console->fs, name, &view);
 
-            if(data) SCOPE(free(data))
+            if(loaded) SCOPE(fs_view_close(&view))
             {
                 tic_cartridge* cart = newCart();
 
                 SCOPE(free(cart))
                 {
-                    tic_cart_load(cart, data, size);
+                    tic_cart_load(cart, view.data, view.size);
                     loadCartSection(console, cart, section);
                     onCartLoaded(console, name, section);
                 }
             }
             else if(tic_tool_has_ext(param, PngExt) && tic_fs_exists(console->fs, param))
             {
-                png_buffer buffer;
-                buffer.data = tic_fs_load(console->fs, param, &buffer.size);
-
-                SCOPE(free(buffer.data))
+                if(tic_fs_view(console->fs, param, &view)) SCOPE(fs_view_close(&view))
                 {
-                    tic_cartridge* cart = loadPngCart(buffer);
+                    tic_cartridge* cart = loadPngCart((png_buffer){(u8*)view.data, view.size});
 
                     if(cart) SCOPE(free(cart))
                     {
@@ -922,15 +922,13 @@ static void onLoadCommandConfirmed(Console* console)
 #if defined(TIC80_PRO)
                 if(tic_project_ext(name))
                 {
-                    void* data = tic_fs_load(console->fs, name, &size);
-
-                    if(data) SCOPE(free(data))
+                    if(tic_fs_view(console->fs, name, &view)) SCOPE(fs_view_close(&view))
                     {
                         tic_cartridge* cart = newCart();
 
                         SCOPE(free(cart))
                         {
-                            tic_project_load(name, data, size, cart);
+                            tic_project_load(name, (const char*)view.data, view.size, cart);
                             loadCartSection(console, cart, section);
                             onCartLoaded(console, name, section);
                         }
@@ -2177,159 +2175,309 @@ static void drawShadowText(tic_mem* tic, const char* text, s32 x, s32 y, tic_col
 
 const char* readMetatag(const char* code, const char* tag, const char* comment);
 
-static CartSaveResult saveCartName(Console* console, const char* name)
+typedef struct CartSave CartSave;
+
+struct CartSave
 {
+    Console* console;
+
+    char name[TICNAME_MAX];
+    char path[TICNAME_MAX];
+
+    // the cart as it was when the save was requested
+    tic_cartridge* cart;
+
+    // cover title for png carts, drawn with the api before the save is queued
+    u32* title;
+
+    bool png;
+    bool done;
+
+    cart_save_callback callback;
+    void* data;
+
+#if defined(USE_LIBUV)
+    uv_work_t work;
+#endif
+
+    CartSave* next;
+};
+
+enum {CoverWidth = 256, TitleWidth = 224, TitleHeight = 40};
+
+static void drawCoverTitle(Console* console, u32* title)
+{
+    enum{Scale = 2, Row = TIC_FONT_HEIGHT * 2 * Scale};
+
     tic_mem* tic = console->tic;
 
-    bool success = false;
+    tic_api_cls(tic, tic_color_dark_grey);
 
-    if(name && strlen(name))
+    const char* comment = tic_core_script_config(tic)->singleComment;
+
+    char* name = tic_tool_metatag(tic->cart.code.data, "title", comment);
+    if(name)
     {
-        u8* buffer = (u8*)malloc(sizeof(tic_cartridge) * 3);
+        drawShadowText(tic, name, 0, 0, tic_color_white, Scale);
+        free(name);
+    }
 
-        if(buffer)
+    char* author = tic_tool_metatag(tic->cart.code.data, "author", comment);
+    if(author)
+    {
+        char buf[TICNAME_MAX];
+        snprintf(buf, sizeof buf, "by %s", author);
+        drawShadowText(tic, buf, 0, Row, tic_color_grey, Scale);
+        free(author);
+    }
+
+    const u8* screen = tic->ram->vram.screen.data;
+    const tic_rgb* pal = getConfig(console->studio)->cart->bank0.palette.vbank0.colors;
+
+    for(s32 y = 0; y < TitleHeight; y++)
+        for(s32 x = 0; x < TitleWidth; x++)
+            title[TitleWidth * y + x] = tic_rgba(pal + tic_tool_peek4(screen, y * TIC80_WIDTH + x));
+}
+
+static png_buffer encodePngCart(const CartSave* save)
+{
+    png_buffer cover;
+
+    {
+        static const u8 Cartridge[] = 
         {
-            if(strcmp(name, CONFIG_TIC_PATH) == 0)
-            {
-                console->config->save(console->config);
-                studioRomSaved(console->studio);
-                free(buffer);
-                return CART_SAVE_OK;
-            }
-            else
-            {
-                s32 size = 0;
+            #include "../build/assets/cart.png.dat"
+        };
 
-                if(tic_tool_has_ext(name, PngExt))
-                {
-                    png_buffer cover;
+        png_buffer template = {(u8*)Cartridge, sizeof Cartridge};
+        png_img img = png_read(template);
 
-                    {
-                        enum{CoverWidth = 256};
+        // draw screen
+        {
+            enum{PaddingLeft = 8, PaddingTop = 8};
 
-                        static const u8 Cartridge[] = 
-                        {
-                            #include "../build/assets/cart.png.dat"
-                        };
+            const tic_bank* bank = &save->cart->bank0;
+            const tic_rgb* pal = bank->palette.vbank0.colors;
+            const u8* screen = bank->screen.data;
+            u32* ptr = img.values + PaddingTop * CoverWidth + PaddingLeft;
 
-                        png_buffer template = {(u8*)Cartridge, sizeof Cartridge};
-                        png_img img = png_read(template);
+            for(s32 i = 0; i < TIC80_WIDTH * TIC80_HEIGHT; i++)
+                ptr[i / TIC80_WIDTH * CoverWidth + i % TIC80_WIDTH] = tic_rgba(pal + tic_tool_peek4(screen, i));
+        }
 
-                        // draw screen
-                        {
-                            enum{PaddingLeft = 8, PaddingTop = 8};
+        // draw title/author/desc
+        {
+            enum{PaddingTop = 162, PaddingLeft = 16};
 
-                            const tic_bank* bank = &tic->cart.bank0;
-                            const tic_rgb* pal = bank->palette.vbank0.colors;
-                            const u8* screen = bank->screen.data;
-                            u32* ptr = img.values + PaddingTop * CoverWidth + PaddingLeft;
+            u32* ptr = img.values + PaddingTop * CoverWidth + PaddingLeft;
 
-                            for(s32 i = 0; i < TIC80_WIDTH * TIC80_HEIGHT; i++)
-                                ptr[i / TIC80_WIDTH * CoverWidth + i % TIC80_WIDTH] = tic_rgba(pal + tic_tool_peek4(screen, i));
-                        }
+            for(s32 y = 0; y < TitleHeight; y++)
+                memcpy(ptr + CoverWidth * y, save->title + TitleWidth * y, TitleWidth * sizeof(u32));
+        }
 
-                        // draw title/author/desc
-                        {
-                            enum{Width = 224, Height = 40, PaddingTop = 162, PaddingLeft = 16, Scale = 2, Row = TIC_FONT_HEIGHT * 2 * Scale};
-
-                            tic_api_cls(tic, tic_color_dark_grey);
-
-                            const char* comment = tic_core_script_config(tic)->singleComment;
-
-                            char* title = tic_tool_metatag(tic->cart.code.data, "title", comment);
-                            if(title)
-                            {
-                                drawShadowText(tic, title, 0, 0, tic_color_white, Scale);
-                                free(title);
-                            }
-
-                            char* author = tic_tool_metatag(tic->cart.code.data, "author", comment);
-                            if(author)
-                            {
-                                char buf[TICNAME_MAX];
-                                snprintf(buf, sizeof buf, "by %s", author);
-                                drawShadowText(tic, buf, 0, Row, tic_color_grey, Scale);
-                                free(author);
-                            }
-
-                            u32* ptr = img.values + PaddingTop * CoverWidth + PaddingLeft;
-                            const u8* screen = tic->ram->vram.screen.data;
-                            const tic_rgb* pal = getConfig(console->studio)->cart->bank0.palette.vbank0.colors;
-
-                            for(s32 y = 0; y < Height; y++)
-                                for(s32 x = 0; x < Width; x++)
-                                    ptr[CoverWidth * y + x] = tic_rgba(pal + tic_tool_peek4(screen, y * TIC80_WIDTH + x));
-                        }
+        cover = png_write(img);
 
-                        cover = png_write(img);
+        free(img.data);
+    }
 
-                        free(img.data);
-                    }
+    png_buffer zip = png_create(sizeof(tic_cartridge));
 
-                    png_buffer zip = png_create(sizeof(tic_cartridge));
+    {
+        png_buffer cart = png_create(sizeof(tic_cartridge));
+        cart.size = tic_cart_save(save->cart, cart.data);
+        zip.size = tic_tool_zip(zip.data, zip.size, cart.data, cart.size);
+        free(cart.data);                        
+    }
 
-                    {
-                        png_buffer cart = png_create(sizeof(tic_cartridge));
-                        cart.size = tic_cart_save(&tic->cart, cart.data);
-                        zip.size = tic_tool_zip(zip.data, zip.size, cart.data, cart.size);
-                        free(cart.data);                        
-                    }
-                    
-                    png_buffer result = png_encode(cover, zip);
-                    free(zip.data);
-                    free(cover.data);
+    png_buffer result = png_encode(cover, zip);
+    free(zip.data);
+    free(cover.data);
 
-                    buffer = result.data;
-                    size = result.size;
-                }
+    return result;
+}
+
+// runs on the worker, doesn't touch the console
+static void writeCart(CartSave* save)
+{
+    u8* buffer = NULL;
+    s32 size = 0;
+
+    if(save->png)
+    {
+        png_buffer result = encodePngCart(save);
+
+        buffer = result.data;
+        size = result.size;
+    }
+    else if((buffer = malloc(sizeof(tic_cartridge) * 3)))
+    {
 #if defined(TIC80_PRO)
-                else if(tic_project_ext(name))
-                {
-                    size = tic_project_save(name, buffer, &tic->cart);
-                }
+        if(tic_project_ext(save->name))
+            size = tic_project_save(save->name, buffer, save->cart);
+        else
 #endif
-                else
-                {
-                    name = getCartName(name);
-                    size = tic_cart_save(&tic->cart, buffer);
-                }
+            size = tic_cart_save(save->cart, buffer);
+    }
 
-                if(size && tic_fs_save(console->fs, name, buffer, size, true))
-                {
-                    setCartName(console, name, tic_fs_path(console->fs, name));
-                    success = true;
-                    studioRomSaved(console->studio);
-                }
-            }
+    save->done = size && fs_replace(save->path, buffer, size);
+
+    free(buffer);
+}
 
-            free(buffer);
+static void startSave(Console* console);
+
+static void finishSave(CartSave* save)
+{
+    Console* console = save->console;
+    console->saves = save->next;
+
+    // no callback when the console is being closed and only waits for the file
+    if(save->callback)
+    {
+        if(save->done)
+        {
+            setCartName(console, save->name, save->path);
+            studioRomSaved(console->studio, save->cart);
         }
+
+        save->callback(save->done ? CART_SAVE_OK : CART_SAVE_ERROR, save->data);
+    }
+
+    free(save->cart);
+    free(save->title);
+    free(save);
+
+    if(console->saves)
+        startSave(console);
+}
+
+#if defined(USE_LIBUV)
+
+static void onSaveWork(uv_work_t* work)
+{
+    writeCart(work->data);
+}
+
+static void onSaveDone(uv_work_t* work, s32 status)
+{
+    finishSave(work->data);
+}
+
+#endif
+
+static void startSave(Console* console)
+{
+    CartSave* save = console->saves;
+
+#if defined(USE_LIBUV)
+    save->work.data = save;
+
+    // the loop is run by the studio every frame
+    if(uv_queue_work(uv_default_loop(), &save->work, onSaveWork, onSaveDone) == 0)
+        return;
+#endif
+
+    writeCart(save);
+    finishSave(save);
+}
+
+// the cart is copied right away, encoding and writing are done in the background
+static void saveCartName(Console* console, const char* name, cart_save_callback callback, void* data)
+{
+    if(!name || !strlen(name))
+    {
+        if(!strlen(console->rom.name))
+        {
+            callback(CART_SAVE_MISSING_NAME, data);
+            return;
+        }
+
+        name = console->rom.name;
+    }
+
+    tic_mem* tic = console->tic;
+
+    if(strcmp(name, CONFIG_TIC_PATH) == 0)
+    {
+        console->config->save(console->config);
+        studioRomSaved(console->studio, &tic->cart);
+        callback(CART_SAVE_OK, data);
+        return;
+    }
+
+    CartSave* save = calloc(1, sizeof(CartSave));
+    bool png = tic_tool_has_ext(name, PngExt);
+
+    if(!save || !(save->cart = malloc(sizeof(tic_cartridge)))
+        || (png && !(save->title = malloc(TitleWidth * TitleHeight * sizeof(u32)))))
+    {
+        if(save)
+            free(save->cart);
+
+        free(save);
+        callback(CART_SAVE_ERROR, data);
+        return;
     }
-    else if (strlen(console->rom.name))
+
+    memcpy(save->cart, &tic->cart, sizeof(tic_cartridge));
+
+    if(png)
     {
-        return saveCartName(console, console->rom.name);
+        save->png = true;
+        drawCoverTitle(console, save->title);
     }
-    else return CART_SAVE_MISSING_NAME;
+#if defined(TIC80_PRO)
+    else if(tic_project_ext(name)) {}
+#endif
+    else name = getCartName(name);
+
+    snprintf(save->name, sizeof save->name, "%s", name);
+    snprintf(save->path, sizeof save->path, "%s", tic_fs_path(console->fs, name));
+
+    save->console = console;
+    save->callback = callback;
+    save->data = data;
 
-    return success ? CART_SAVE_OK : CART_SAVE_ERROR;
+    // saves are written in order, so the last one wins
+    CartSave** last = &console->saves;
+    while(*last)
+        last = &(*last)->next;
+
+    *last = save;
+
+    if(console->saves == save)
+        startSave(console);
 }
 
-static CartSaveResult saveCart(Console* console)
+static void saveCart(Console* console, cart_save_callback callback, void* data)
 {
-    return saveCartName(console, NULL);
+    saveCartName(console, NULL, callback, data);
 }
 
-static void onSaveCommandConfirmed(Console* console)
+// the loop runs the callbacks of every module, so it's done before the studio frees any
+static void flushSaves(Console* console)
 {
-    CartSaveResult rom = saveCartName(console, console->desc->count ? console->desc->params->key : NULL);
+    for(CartSave* save = console->saves; save; save = save->next)
+        save->callback = NULL;
 
-    if(rom == CART_SAVE_OK)
+#if defined(USE_LIBUV)
+    // the queued carts are still written
+    while(console->saves)
+        uv_run(uv_default_loop(), UV_RUN_ONCE);
+#endif
+}
+
+static void onSaveCommandDone(CartSaveResult result, void* data)
+{
+    Console* console = data;
+
+    if(result == CART_SAVE_OK)
     {
         printBack(console, "\ncart ");
         printFront(console, console->rom.name);
         printBack(console, " saved!\n");
     }
-    else if(rom == CART_SAVE_MISSING_NAME)
+    else if(result == CART_SAVE_MISSING_NAME)
         printBack(console, "\ncart name is missing\n");
     else
         printBack(console, "\ncart saving error");
@@ -2337,6 +2485,11 @@ static void onSaveCommandConfirmed(Console* console)
     commandDone(console);
 }
 
+static void onSaveCommandConfirmed(Console* console)
+{
+    saveCartName(console, console->desc->count ? console->desc->params->key : NULL, onSaveCommandDone, console);
+}
+
 static void onSaveCommand(Console* console)
 {
     const char* param = console->desc->count ? console->desc->params->key : NULL;
@@ -2978,36 +3131,31 @@ static void onExport_help(Console* console, const char* param, const char* name,
     }
 }
 
+// the listing can be scanned in the background, so the input is kept to
+// check the user didn't change it before the completion is inserted
 typedef struct
 {
     Console* console;
-    char* name;
+    char* input;
+    s32 offset;
+    s32 prefix;
+    char name[TICNAME_MAX];
 } PredictFilenameData;
 
 static bool predictFilename(const char* name, const char* title, const char* hash, s32 id, void* data, bool dir)
 {
     PredictFilenameData* predictFilenameData = data;
-    Console* console = predictFilenameData->console;
+    const char* prefix = predictFilenameData->input + predictFilenameData->prefix;
 
-    if(strstr(name, predictFilenameData->name) == name)
+    if(strstr(name, prefix) == name)
     {
-        strcpy(predictFilenameData->name, name);
-        memset(console->color + getInputOffset(console), CONSOLE_INPUT_COLOR, strlen(name));
+        strncpy(predictFilenameData->name, name, sizeof predictFilenameData->name - 1);
         return false;
     }
 
     return true;
 }
 
-static void predictFilenameDone(void* data)
-{
-    PredictFilenameData* predictFilenameData = data;
-    Console* console = predictFilenameData->console;
-
-    console->input.pos = strlen(console->input.text);
-    free(predictFilenameData);
-}
-
 static void insertInputText(Console* console, const char* text)
 {
     s32 size = strlen(text);
@@ -3033,6 +3181,23 @@ static void insertInputText(Console* console, const char* text)
     clearSelection(console);
 }
 
+static void predictFilenameDone(void* data)
+{
+    PredictFilenameData* predictFilenameData = data;
+    Console* console = predictFilenameData->console;
+
+    if(*predictFilenameData->name
+        && console->input.text - console->text == predictFilenameData->offset
+        && strcmp(console->input.text, predictFilenameData->input) == 0)
+    {
+        console->input.pos = strlen(console->input.text);
+        insertInputText(console, predictFilenameData->name + strlen(predictFilenameData->input + predictFilenameData->prefix));
+    }
+
+    free(predictFilenameData->input);
+    free(predictFilenameData);
+}
+
 static void processConsoleTab(Console* console)
 {
     char* input = console->input.text;
@@ -3043,8 +3208,13 @@ static void processConsoleTab(Console* console)
 
         if(param && strlen(++param))
         {
-            PredictFilenameData data = { console, param };
-            tic_fs_enum(console->fs, predictFilename, predictFilenameDone, MOVE(data));
+            PredictFilenameData* data = calloc(1, sizeof(PredictFilenameData));
+            data->console = console;
+            data->input = strdup(input);
+            data->offset = (s32)(input - console->text);
+            data->prefix = (s32)(param - input);
+
+            tic_fs_enum(console->fs, predictFilename, predictFilenameDone, data);
         }
         else
         {
@@ -3922,6 +4092,7 @@ void initConsole(Console* console, Studio* studio, tic_fs* fs, tic_net* net, Con
         .trace = trace,
         .tick = tick,
         .save = saveCart,
+        .flush = flushSaves,
         .done = commandDone,
         .cursor = {.pos.x = 1, .pos.y = 3, .delay = 0},
         .input = console->text,
@@ -33,6 +33,8 @@ typedef enum
     CART_SAVE_MISSING_NAME,
 } CartSaveResult;
 
+typedef void(*cart_save_callback)(CartSaveResult result, void* data);
+
 typedef struct Console Console;
 typedef struct CommandDesc CommandDesc;
 
@@ -103,6 +105,9 @@ struct Console
 
     CommandDesc* desc;
 
+    // saves being written in the background, the first one is in progress
+    struct CartSave* saves;
+
     void(*load)(Console*, const char* path);
     bool(*loadCart)(Console*, const char* path);
     void(*loadByHash)(Console*, const char* name, const char* hash, const char* section, fs_done_callback callback, void* data);
@@ -112,7 +117,10 @@ struct Console
     void(*tick)(Console*);
     void(*done)(Console*);
 
-    CartSaveResult(*save)(Console*);
+    void(*save)(Console*, cart_save_callback callback, void* data);
+
+    // waits for the background saves, no callbacks are called
+    void(*flush)(Console*);
 };
 
 void initConsole(Console*, Studio* studio, struct tic_fs* fs, struct tic_net* net, struct Config* config, StartArgs args);
@@ -23,9 +23,13 @@
 #include "run.h"
 #include "console.h"
 #include "studio/fs.h"
+#include "studio/writer.h"
 #include "ext/md5.h"
 #include <time.h>
 
+// pmem is written to disk at most once per this period (ms)
+#define PMEM_SAVE_DELAY 1000
+
 static void onTrace(void* data, const char* text, u8 color)
 {
     Run* run = (Run*)data;
@@ -106,30 +110,34 @@ static void tick(Run* run)
 
     tic_mem* tic = run->tic;
 
-    tic_tick_data tickData = 
-    {
-        .error = run->console ? onError : onEmptyError,
-        .trace = run->console ? onTrace : onEmptyTrace,
-        .exit = onExit,
-        .data = run,
-    };
-
-    tic_core_tick(tic, &tickData);
+    tic_core_tick(tic, &run->tickData);
 
     enum {Size = sizeof(tic_persistent)};
 
     if(memcmp(run->pmem.data, tic->ram->persistent.data, Size))
     {
-        tic_fs_saveroot(run->fs, run->saveid, &tic->ram->persistent, Size, true);
+        tic_writer_write(run->writer, tic_fs_pathroot(run->fs, run->saveid), &tic->ram->persistent, Size);
         memcpy(run->pmem.data, tic->ram->persistent.data, Size);
     }
 
+    tic_writer_update(run->writer);
+
     if(run->exit)
         setStudioMode(run->studio, TIC_CONSOLE_MODE);
 }
 
+static void flush(Run* run)
+{
+    tic_writer_flush(run->writer);
+}
+
 void initRun(Run* run, Console* console, tic_fs* fs, Studio* studio)
 {
+    tic_writer* writer = run->writer ? run->writer : tic_writer_create(PMEM_SAVE_DELAY);
+
+    // pmem of the previous run has to be on disk before it's loaded again
+    tic_writer_flush(writer);
+
     *run = (Run)
     {
         .studio = studio,
@@ -137,7 +145,16 @@ void initRun(Run* run, Console* console, tic_fs* fs, Studio* studio)
         .console = console,
         .fs = fs,
         .tick = tick,
+        .flush = flush,
+        .writer = writer,
         .exit = false,
+        .tickData = 
+        {
+            .error = console ? onError : onEmptyError,
+            .trace = console ? onTrace : onEmptyTrace,
+            .exit = onExit,
+            .data = run,
+        },
     };
 
     {
@@ -163,5 +180,8 @@ void initRun(Run* run, Console* console, tic_fs* fs, Studio* studio)
 
 void freeRun(Run* run)
 {
+    if(run->writer)
+        tic_writer_delete(run->writer);
+
     free(run);
 }
\ No newline at end of file
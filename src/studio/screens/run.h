@@ -38,8 +38,13 @@ struct Run
     
     char saveid[TICNAME_MAX];
     tic_persistent pmem;
+    struct tic_writer* writer;
+
+    // kept alive between ticks, the core refers to it on pause/resume/reload
+    tic_tick_data tickData;
 
     void(*tick)(Run*);
+    void(*flush)(Run*);
 };
 
 void initRun(Run*, struct Console*, struct tic_fs*, Studio* studio);
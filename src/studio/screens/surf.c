@@ -23,6 +23,7 @@
 #include "surf.h"
 #include "studio/fs.h"
 #include "studio/net.h"
+#include "studio/covers.h"
 #include "console.h"
 #include "menu.h"
 #include "ext/gif.h"
@@ -66,6 +67,7 @@ struct SurfItem
     tic_palette* palette;
 
     bool coverLoading;
+    bool coverReady;
     bool dir;
     bool project;
 };
@@ -244,6 +246,17 @@ static s32 itemcmp(const void* a, const void* b)
     return 0;
 }
 
+static void requestLocalCover(Surf* surf, s32 pos)
+{
+    if(pos >= 0 && pos < surf->menu.count)
+    {
+        const SurfItem* item = &surf->menu.items[pos];
+
+        if(!item->dir && !item->coverReady)
+            tic_covers_load(surf->covers, tic_fs_path(surf->fs, item->name), pos);
+    }
+}
+
 static void addMenuItemsDone(void* data)
 {
     AddMenuItemData* addMenuItemData = data;
@@ -253,8 +266,14 @@ static void addMenuItemsDone(void* data)
     surf->menu.count = addMenuItemData->count;
 
     if(!tic_fs_ispubdir(surf->fs))
+    {
         qsort(surf->menu.items, surf->menu.count, sizeof *surf->menu.items, itemcmp);
 
+        // scan the whole folder in the background, from the top
+        for(s32 i = surf->menu.count - 1; i >= 0; i--)
+            requestLocalCover(surf, i);
+    }
+
     if (addMenuItemData->done)
         addMenuItemData->done(addMenuItemData->data);
 
@@ -265,6 +284,8 @@ static void addMenuItemsDone(void* data)
 
 static void resetMenu(Surf* surf)
 {
+    tic_covers_clear(surf->covers);
+
     if(surf->menu.items)
     {
         for(s32 i = 0; i < surf->menu.count; i++)
@@ -364,10 +385,12 @@ static void requestCover(Surf* surf, SurfItem* item)
         s32 size = 0;
         void* data = tic_fs_loadroot(surf->fs, coverLoadingData.cachePath, &size);
 
+        // covers are addressed by the cart hash and never change
         if (data)
         {
             updateMenuItemCover(surf, surf->menu.pos, data, size);
             free(data);
+            return;
         }
     }
 
@@ -377,10 +400,40 @@ static void requestCover(Surf* surf, SurfItem* item)
     tic_net_get(surf->net, path, coverLoaded, MOVE(coverLoadingData));
 }
 
+static void prefetchCovers(Surf* surf)
+{
+    // the latest request is loaded first, so the current item goes last
+    for(s32 i = PAGE; i > 0; i--)
+    {
+        requestLocalCover(surf, surf->menu.pos + i);
+        requestLocalCover(surf, surf->menu.pos - i);
+    }
+
+    requestLocalCover(surf, surf->menu.pos);
+}
+
+static void updateCovers(Surf* surf)
+{
+    tic_covers_update(surf->covers);
+
+    for(tic_cover* cover; (cover = tic_covers_done(surf->covers)); free(cover))
+    {
+        if(cover->id >= surf->menu.count)
+            continue;
+
+        SurfItem* item = &surf->menu.items[cover->id];
+        item->coverReady = true;
+
+        if(cover->found && !item->cover)
+        {
+            memcpy((item->palette = malloc(sizeof(tic_palette))), &cover->palette, sizeof(tic_palette));
+            memcpy((item->cover = malloc(sizeof(tic_screen))), &cover->screen, sizeof(tic_screen));
+        }
+    }
+}
+
 static void loadCover(Surf* surf)
 {
-    tic_mem* tic = surf->tic;
-    
     SurfItem* item = getMenuItem(surf);
     
     if(item->coverLoading)
@@ -390,46 +443,7 @@ static void loadCover(Surf* surf)
 
     if(!tic_fs_ispubdir(surf->fs))
     {
-
-        s32 size = 0;
-        void* data = tic_fs_load(surf->fs, item->name, &size);
-
-        if(data)
-        {
-            tic_cartridge* cart = (tic_cartridge*)malloc(sizeof(tic_cartridge));
-
-            if(cart)
-            {
-
-                if(tic_tool_has_ext(item->name, PngExt))
-                {
-                    tic_cartridge* pngcart = loadPngCart((png_buffer){data, size});
-
-                    if(pngcart)
-                    {
-                        memcpy(cart, pngcart, sizeof(tic_cartridge));
-                        free(pngcart);
-                    }
-                    else memset(cart, 0, sizeof(tic_cartridge));
-                }
-#if defined(TIC80_PRO)
-                else if(tic_project_ext(item->name))
-                    tic_project_load(item->name, data, size, cart);
-#endif
-                else
-                    tic_cart_load(cart, data, size);
-
-                if(!EMPTY(cart->bank0.screen.data) && !EMPTY(cart->bank0.palette.vbank0.data))
-                {
-                    memcpy((item->palette = malloc(sizeof(tic_palette))), &cart->bank0.palette.vbank0, sizeof(tic_palette));
-                    memcpy((item->cover = malloc(sizeof(tic_screen))), &cart->bank0.screen, sizeof(tic_screen));
-                }
-
-                free(cart);
-            }
-
-            free(data);
-        }
+        prefetchCovers(surf);
     }
     else if(item->hash && !item->cover)
     {
@@ -575,18 +589,19 @@ static void loadCart(Surf* surf)
 
     if(tic_tool_has_ext(item->name, PngExt))
     {
-        s32 size = 0;
-        void* data = tic_fs_load(surf->fs, item->name, &size);
+        fs_view view;
 
-        if(data)
+        if(tic_fs_view(surf->fs, item->name, &view))
         {
-            tic_cartridge* cart = loadPngCart((png_buffer){data, size});
+            tic_cartridge* cart = loadPngCart((png_buffer){(u8*)view.data, view.size});
 
             if(cart)
             {
                 surf->anim.movie = resetMovie(&surf->anim.play);
                 free(cart);
             }
+
+            fs_view_close(&view);
         }
     }
     else surf->anim.movie = resetMovie(&surf->anim.play);
@@ -713,6 +728,7 @@ static void tick(Surf* surf)
 
     if (surf->menu.count > 0)
     {
+        updateCovers(surf);
         loadCover(surf);
 
         tic_screen* cover = getMenuItem(surf)->cover;
@@ -807,6 +823,12 @@ void initSurf(Surf* surf, Studio* studio, struct Console* console)
 {
     freeAnim(surf);
 
+    tic_covers* covers = surf->covers 
+        ? surf->covers 
+        : tic_covers_create(tic_fs_pathroot(console->fs, TIC_CACHE));
+
+    tic_covers_clear(covers);
+
     *surf = (Surf)
     {
         .studio = studio,
@@ -814,6 +836,7 @@ void initSurf(Surf* surf, Studio* studio, struct Console* console)
         .console = console,
         .fs = console->fs,
         .net = console->net,
+        .covers = covers,
         .tick = tick,
         .ticks = 0,
         .init = false,
@@ -891,5 +914,6 @@ void freeSurf(Surf* surf)
 {
     freeAnim(surf);
     resetMenu(surf);
+    tic_covers_delete(surf->covers);
     free(surf);
 }
\ No newline at end of file
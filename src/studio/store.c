@@ -0,0 +1,602 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "store.h"
+#include "fs.h"
+#include "cart.h"
+#include "ext/md5.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#define HASH_SIZE 16
+#define STORE_MEMORY (4 * 1024 * 1024)
+#define MANIFEST_VERSION 1
+
+static const u8 ManifestMagic[] = {'T', 'I', 'C', 'S'};
+
+typedef struct
+{
+    u8 magic[sizeof ManifestMagic];
+    u32 version;
+    u32 count;
+} ManifestHeader;
+
+typedef struct
+{
+    u8 header[TIC_CHUNK_HEADER_SIZE];
+    u32 size;
+    u8 hash[HASH_SIZE];
+} ManifestEntry;
+
+typedef struct CachedChunk CachedChunk;
+
+struct CachedChunk
+{
+    u8 hash[HASH_SIZE];
+    u8* data;
+    s32 size;
+    CachedChunk* next;
+};
+
+struct tic_store
+{
+    char* dir;
+
+    // chunks in memory, most recent first
+    CachedChunk* chunks;
+    s32 memory;
+};
+
+typedef struct
+{
+    tic_store* store;
+    ManifestEntry* entries;
+    s32 count;
+    s32 capacity;
+} SaveData;
+
+static void hashData(const void* data, s32 size, u8 hash[HASH_SIZE])
+{
+    MD5_CTX c;
+    MD5_Init(&c);
+    MD5_Update(&c, data, size);
+    MD5_Final(hash, &c);
+}
+
+static char* chunkPath(tic_store* store, const u8 hash[HASH_SIZE])
+{
+    char* path = malloc(strlen(store->dir) + HASH_SIZE * 2 + 1);
+    char* ptr = path + sprintf(path, "%s", store->dir);
+
+    for(s32 i = 0; i < HASH_SIZE; i++)
+        ptr += sprintf(ptr, "%02x", hash[i]);
+
+    return path;
+}
+
+static CachedChunk* findChunk(tic_store* store, const u8 hash[HASH_SIZE])
+{
+    for(CachedChunk **ptr = &store->chunks, *chunk; (chunk = *ptr); ptr = &chunk->next)
+    {
+        if(memcmp(chunk->hash, hash, HASH_SIZE) == 0)
+        {
+            *ptr = chunk->next;
+            chunk->next = store->chunks;
+            store->chunks = chunk;
+            return chunk;
+        }
+    }
+
+    return NULL;
+}
+
+static void freeChunk(tic_store* store, CachedChunk* chunk)
+{
+    store->memory -= chunk->size;
+    free(chunk->data);
+    free(chunk);
+}
+
+// takes ownership of the data, the new chunk stays at the top
+static void keepChunk(tic_store* store, const u8 hash[HASH_SIZE], u8* data, s32 size)
+{
+    CachedChunk* chunk = NEW(CachedChunk);
+    memcpy(chunk->hash, hash, HASH_SIZE);
+    chunk->data = data;
+    chunk->size = size;
+    chunk->next = store->chunks;
+    store->chunks = chunk;
+    store->memory += size;
+
+    // drop the least recently used chunks over the budget
+    CachedChunk** ptr = &chunk->next;
+    for(s32 memory = size; *ptr; ptr = &(*ptr)->next)
+    {
+        memory += (*ptr)->size;
+
+        if(memory > STORE_MEMORY)
+        {
+            while(*ptr)
+            {
+                CachedChunk* next = (*ptr)->next;
+                freeChunk(store, *ptr);
+                *ptr = next;
+            }
+
+            break;
+        }
+    }
+}
+
+static bool loadChunk(tic_store* store, const ManifestEntry* entry, u8* dst)
+{
+    // chunks without data, like the default bank marks, aren't stored
+    if(entry->size == 0)
+        return true;
+
+    const CachedChunk* chunk = findChunk(store, entry->hash);
+
+    if(!chunk)
+    {
+        char* path = chunkPath(store, entry->hash);
+        s32 size = 0;
+        u8* data = fs_read(path, &size);
+        free(path);
+
+        if(!data)
+            return false;
+
+        u8 hash[HASH_SIZE];
+        hashData(data, size, hash);
+
+        if(size != entry->size || memcmp(hash, entry->hash, HASH_SIZE) != 0)
+        {
+            free(data);
+            return false;
+        }
+
+        keepChunk(store, entry->hash, data, size);
+        chunk = store->chunks;
+    }
+
+    if(chunk->size != entry->size)
+        return false;
+
+    memcpy(dst, chunk->data, chunk->size);
+
+    return true;
+}
+
+static bool validChunk(const char* path, const u8 hash[HASH_SIZE], s32 size)
+{
+    s32 fileSize = 0;
+    u8* data = fs_read(path, &fileSize);
+    bool valid = false;
+
+    if(data && fileSize == size)
+    {
+        u8 fileHash[HASH_SIZE];
+        hashData(data, size, fileHash);
+        valid = memcmp(fileHash, hash, HASH_SIZE) == 0;
+    }
+
+    free(data);
+
+    return valid;
+}
+
+static bool saveChunk(const u8* header, const u8* data, s32 size, void* userdata)
+{
+    SaveData* saveData = userdata;
+    tic_store* store = saveData->store;
+
+    if(saveData->count == saveData->capacity)
+    {
+        s32 capacity = saveData->capacity ? saveData->capacity * 2 : 32;
+        ManifestEntry* entries = realloc(saveData->entries, capacity * sizeof(ManifestEntry));
+
+        if(!entries)
+            return false;
+
+        saveData->entries = entries;
+        saveData->capacity = capacity;
+    }
+
+    ManifestEntry* entry = &saveData->entries[saveData->count++];
+    memcpy(entry->header, header, TIC_CHUNK_HEADER_SIZE);
+    entry->size = size;
+    hashData(data, size, entry->hash);
+
+    // the chunk is already stored when another cart has it, a damaged file is written again
+    if(size && !findChunk(store, entry->hash))
+    {
+        char* path = chunkPath(store, entry->hash);
+        bool stored = validChunk(path, entry->hash, size) || fs_replace(path, data, size);
+        free(path);
+
+        if(!stored)
+            return false;
+
+        u8* copy = malloc(size);
+        if(copy)
+        {
+            memcpy(copy, data, size);
+            keepChunk(store, entry->hash, copy, size);
+        }
+    }
+
+    return true;
+}
+
+tic_store* tic_store_create(const char* dir)
+{
+    tic_store* store = calloc(1, sizeof(tic_store));
+
+    store->dir = strdup(dir);
+
+    return store;
+}
+
+bool tic_store_save(tic_store* store, const char* manifest, const void* buffer, s32 size)
+{
+    SaveData saveData = {store};
+    bool done = false;
+
+    if(size > 0 && tic_cart_chunks(buffer, size, saveChunk, &saveData) == size)
+    {
+        ManifestHeader header = {.version = MANIFEST_VERSION, .count = saveData.count};
+        memcpy(header.magic, ManifestMagic, sizeof ManifestMagic);
+
+        s32 entriesSize = saveData.count * sizeof(ManifestEntry);
+        u8* data = malloc(sizeof header + entriesSize);
+
+        if(data)
+        {
+            memcpy(data, &header, sizeof header);
+            memcpy(data + sizeof header, saveData.entries, entriesSize);
+
+            done = fs_replace(manifest, data, sizeof header + entriesSize);
+
+            free(data);
+        }
+    }
+
+    free(saveData.entries);
+
+    return done;
+}
+
+// returns the manifest with the header checked or NULL, the entries go after the header
+static u8* readManifest(const char* path, u32* count)
+{
+    s32 size = 0;
+    u8* data = fs_read(path, &size);
+
+    if(!data)
+        return NULL;
+
+    ManifestHeader header;
+
+    if(size >= (s32)sizeof header)
+    {
+        memcpy(&header, data, sizeof header);
+
+        if(memcmp(header.magic, ManifestMagic, sizeof ManifestMagic) == 0
+            && header.version == MANIFEST_VERSION
+            && header.count == (size - sizeof header) / sizeof(ManifestEntry)
+            && (size - sizeof header) % sizeof(ManifestEntry) == 0)
+        {
+            *count = header.count;
+            return data;
+        }
+    }
+
+    free(data);
+
+    return NULL;
+}
+
+static void readEntry(const u8* manifest, u32 index, ManifestEntry* entry)
+{
+    memcpy(entry, manifest + sizeof(ManifestHeader) + index * sizeof(ManifestEntry), sizeof(ManifestEntry));
+}
+
+void* tic_store_load(tic_store* store, const char* manifest, s32* size)
+{
+    u32 count = 0;
+    u8* data = readManifest(manifest, &count);
+
+    if(!data)
+        return NULL;
+
+    u8* buffer = NULL;
+    s32 total = 0;
+    bool valid = true;
+
+    for(u32 i = 0; i < count; i++)
+    {
+        ManifestEntry entry;
+        readEntry(data, i, &entry);
+
+        if(entry.size > TIC_BANK_SIZE)
+        {
+            valid = false;
+            break;
+        }
+
+        total += TIC_CHUNK_HEADER_SIZE + entry.size;
+    }
+
+    if(valid && total && (buffer = malloc(total)))
+    {
+        u8* ptr = buffer;
+
+        for(u32 i = 0; i < count; i++)
+        {
+            ManifestEntry entry;
+            readEntry(data, i, &entry);
+
+            memcpy(ptr, entry.header, TIC_CHUNK_HEADER_SIZE);
+            ptr += TIC_CHUNK_HEADER_SIZE;
+
+            if(!loadChunk(store, &entry, ptr))
+            {
+                free(buffer);
+                buffer = NULL;
+                break;
+            }
+
+            ptr += entry.size;
+        }
+
+        if(buffer)
+        {
+            *size = total;
+
+            // the manifest date is the last use, tic_store_trim keeps the recent ones
+            fs_touch(manifest);
+        }
+    }
+
+    free(data);
+
+    return buffer;
+}
+
+typedef struct
+{
+    char* name;
+    u64 date;
+} StoredManifest;
+
+typedef struct
+{
+    StoredManifest* items;
+    s32 count;
+    s32 capacity;
+} ManifestList;
+
+// open addressing set of the chunk hashes referenced by the kept manifests
+typedef struct
+{
+    u8 (*hashes)[HASH_SIZE];
+    bool* used;
+    s32 count;
+    s32 capacity;
+} ChunkSet;
+
+static bool addManifest(const char* name, s64 size, u64 date, void* data)
+{
+    ManifestList* list = data;
+
+    if(list->count == list->capacity)
+    {
+        list->capacity = list->capacity ? list->capacity * 2 : 64;
+        list->items = realloc(list->items, list->capacity * sizeof(StoredManifest));
+    }
+
+    list->items[list->count++] = (StoredManifest){strdup(name), date};
+
+    return true;
+}
+
+static s32 compareManifests(const void* a, const void* b)
+{
+    const StoredManifest *left = a, *right = b;
+
+    // most recently used first
+    return left->date < right->date ? 1 : left->date > right->date ? -1 : 0;
+}
+
+static s32 findSlot(const ChunkSet* set, const u8 hash[HASH_SIZE])
+{
+    u32 slot;
+    memcpy(&slot, hash, sizeof slot);
+
+    for(slot &= set->capacity - 1; set->used[slot]; slot = (slot + 1) & (set->capacity - 1))
+        if(memcmp(set->hashes[slot], hash, HASH_SIZE) == 0)
+            break;
+
+    return slot;
+}
+
+static bool hasChunk(const ChunkSet* set, const u8 hash[HASH_SIZE])
+{
+    return set->capacity && set->used[findSlot(set, hash)];
+}
+
+static void addChunk(ChunkSet* set, const u8 hash[HASH_SIZE])
+{
+    if((set->count + 1) * 2 > set->capacity)
+    {
+        ChunkSet grown = {NULL, NULL, 0, set->capacity ? set->capacity * 2 : 256};
+        grown.hashes = malloc(grown.capacity * HASH_SIZE);
+        grown.used = calloc(grown.capacity, sizeof(bool));
+
+        for(s32 i = 0; i < set->capacity; i++)
+            if(set->used[i])
+                addChunk(&grown, set->hashes[i]);
+
+        free(set->hashes);
+        free(set->used);
+        *set = grown;
+    }
+
+    s32 slot = findSlot(set, hash);
+
+    if(!set->used[slot])
+    {
+        memcpy(set->hashes[slot], hash, HASH_SIZE);
+        set->used[slot] = true;
+        set->count++;
+    }
+}
+
+static bool parseHash(const char* name, u8 hash[HASH_SIZE])
+{
+    if(strlen(name) != HASH_SIZE * 2)
+        return false;
+
+    for(s32 i = 0; i < HASH_SIZE; i++)
+    {
+        u32 byte;
+        if(sscanf(name + i * 2, "%2x", &byte) != 1)
+            return false;
+
+        hash[i] = byte;
+    }
+
+    return true;
+}
+
+typedef struct
+{
+    tic_store* store;
+    const ChunkSet* set;
+} SweepData;
+
+static bool sweepChunk(const char* name, s64 size, u64 date, void* data)
+{
+    SweepData* sweep = data;
+    u8 hash[HASH_SIZE];
+
+    if(parseHash(name, hash) && !hasChunk(sweep->set, hash))
+    {
+        char* path = chunkPath(sweep->store, hash);
+        fs_remove(path);
+        free(path);
+    }
+
+    return true;
+}
+
+void tic_store_trim(tic_store* store, const char* dir, const char* ext, s64 limit, u64 age)
+{
+    ManifestList list = {0};
+    fs_files(dir, ext, addManifest, &list);
+
+    if(list.count)
+        qsort(list.items, list.count, sizeof(StoredManifest), compareManifests);
+
+    // mark the chunks of the recent manifests while they fit the limit
+    ChunkSet set = {0};
+    s64 total = 0;
+    u64 now = time(NULL);
+
+    for(StoredManifest *item = list.items, *end = item + list.count; item != end; item++)
+    {
+        char* path = malloc(strlen(dir) + strlen(item->name) + 1);
+        sprintf(path, "%s%s", dir, item->name);
+
+        u32 count = 0;
+        u8* data = item->date + age >= now ? readManifest(path, &count) : NULL;
+        bool keep = false;
+
+        if(data)
+        {
+            s64 size = 0;
+
+            for(u32 i = 0; i < count; i++)
+            {
+                ManifestEntry entry;
+                readEntry(data, i, &entry);
+
+                if(!hasChunk(&set, entry.hash))
+                    size += entry.size;
+            }
+
+            if((keep = total + size <= limit))
+            {
+                total += size;
+
+                for(u32 i = 0; i < count; i++)
+                {
+                    ManifestEntry entry;
+                    readEntry(data, i, &entry);
+
+                    if(entry.size)
+                        addChunk(&set, entry.hash);
+                }
+            }
+        }
+
+        if(!keep)
+            fs_remove(path);
+
+        free(data);
+        free(path);
+        free(item->name);
+    }
+
+    free(list.items);
+
+    // sweep the chunks no kept manifest refers to, the memory copies go too
+    // so the next save writes them again
+    fs_files(store->dir, NULL, sweepChunk, &(SweepData){store, &set});
+
+    while(store->chunks)
+    {
+        CachedChunk* next = store->chunks->next;
+        freeChunk(store, store->chunks);
+        store->chunks = next;
+    }
+
+    free(set.hashes);
+    free(set.used);
+}
+
+void tic_store_delete(tic_store* store)
+{
+    while(store->chunks)
+    {
+        CachedChunk* next = store->chunks->next;
+        freeChunk(store, store->chunks);
+        store->chunks = next;
+    }
+
+    free(store->dir);
+    free(store);
+}
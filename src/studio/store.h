@@ -0,0 +1,49 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "tic.h"
+
+// Content addressed store of cart chunks. A stored cart is a manifest with
+// the header and the md5 of every chunk, the chunk data is kept once per md5
+// in the store folder, so the carts sharing chunks (remixes, the same sprites
+// or waveforms in several banks) share the files. Recently used chunks are
+// also kept in memory, so assembling a cart related to an already loaded one
+// doesn't touch the disk for the shared part.
+
+typedef struct tic_store tic_store;
+
+tic_store*  tic_store_create    (const char* dir);
+
+// returns false if the buffer isn't made of whole chunks or the data can't be written
+bool        tic_store_save      (tic_store* store, const char* manifest, const void* buffer, s32 size);
+
+// returns the assembled cart or NULL if the manifest or any of its chunks is missing
+void*       tic_store_load      (tic_store* store, const char* manifest, s32* size);
+
+// removes the manifests in the dir not used for the age in seconds or over the size limit
+// of their chunks, least recently used first, then the chunks no manifest refers to
+void        tic_store_trim      (tic_store* store, const char* dir, const char* ext, s64 limit, u64 age);
+
+void        tic_store_delete    (tic_store* store);
@@ -35,7 +35,7 @@
 #include "ext/history.h"
 #include "net.h"
 #include "wave_writer.h"
-#include "ext/gif.h"
+#include "recorder.h"
 
 #endif
 
@@ -57,6 +57,7 @@
 #include <math.h>
 
 #define MD5_HASHSIZE 16
+#define NET_CACHE_SIZE (64 * 1024 * 1024)
 
 #if defined(TIC80_PRO)
 #define TIC_EDITOR_BANKS (TIC_BANKS)
@@ -169,9 +170,9 @@ struct Studio
 
     struct
     {
-        bool record;
+        tic_recorder* recorder;
+        char filename[TICNAME_MAX];
 
-        u32* buffer;
         s32 frames;
         s32 frame;
 
@@ -208,8 +209,6 @@ struct Studio
 
 #if defined(BUILD_EDITORS)
 
-#define FRAME_SIZE (TIC80_FULLWIDTH * TIC80_FULLHEIGHT * sizeof(u32))
-
 static const char VideoGif[] = "video%i.gif";
 static const char ScreenGif[] = "screen%i.gif";
 
@@ -1186,7 +1185,10 @@ void setStudioMode(Studio* studio, EditorMode mode)
         EditorMode prev = studio->mode;
 
         if(prev == TIC_RUN_MODE)
+        {
             tic_core_pause(studio->tic);
+            studio->run->flush(studio->run);
+        }
 
         if(mode != TIC_RUN_MODE)
             tic_api_reset(studio->tic);
@@ -1251,6 +1253,12 @@ void resumeGame(Studio* studio)
 {
     tic_core_resume(studio->tic);
     studio->mode = TIC_RUN_MODE;
+
+    // edits are applied here only, not while typing in the code editor: the cart is paused
+    // there and reloading on every change would report every half-typed line;
+    // errors are reported to the console, otherwise the code can't be applied without restart
+    if(!tic_core_reload(studio->tic) && studio->mode == TIC_RUN_MODE)
+        showPopupMessage(studio, "run the cart to apply code changes");
 }
 
 static inline bool pointInRect(const tic_point* pt, const tic_rect* rect)
@@ -1389,9 +1397,9 @@ static void initModules(Studio* studio)
     initWorldMap(studio);
 }
 
-static void updateHash(Studio* studio)
+static void updateHash(Studio* studio, const tic_cartridge* cart)
 {
-    md5(&studio->tic->cart, sizeof(tic_cartridge), studio->cart.hash.data);
+    md5(cart, sizeof(tic_cartridge), studio->cart.hash.data);
 }
 
 static void updateMDate(Studio* studio)
@@ -1437,10 +1445,11 @@ tic_cartridge* loadPngCart(png_buffer buffer)
     return NULL;
 }
 
-void studioRomSaved(Studio* studio)
+// the cart is the saved copy, it can differ from the edited one when saved in the background
+void studioRomSaved(Studio* studio, const tic_cartridge* cart)
 {
     updateTitle(studio);
-    updateHash(studio);
+    updateHash(studio, cart);
     updateMDate(studio);
 }
 
@@ -1449,7 +1458,7 @@ void studioRomLoaded(Studio* studio)
     initModules(studio);
 
     updateTitle(studio);
-    updateHash(studio);
+    updateHash(studio, &studio->tic->cart);
     updateMDate(studio);
 }
 
@@ -1493,9 +1502,9 @@ void runGame(Studio* studio)
 }
 
 #if defined(BUILD_EDITORS)
-static void saveProject(Studio* studio)
+static void onProjectSaved(CartSaveResult rom, void* data)
 {
-    CartSaveResult rom = studio->console->save(studio->console);
+    Studio* studio = data;
 
     if(rom == CART_SAVE_OK)
     {
@@ -1521,16 +1530,9 @@ static void saveProject(Studio* studio)
     else showPopupMessage(studio, "error: file not saved :(");
 }
 
-static void screen2buffer(u32* buffer, const u32* pixels, const tic_rect* rect)
+static void saveProject(Studio* studio)
 {
-    pixels += rect->y * TIC80_FULLWIDTH;
-
-    for(s32 i = 0; i < rect->h; i++)
-    {
-        memcpy(buffer, pixels + rect->x, rect->w * sizeof(pixels[0]));
-        pixels += TIC80_FULLWIDTH;
-        buffer += rect->w;
-    }
+    studio->console->save(studio->console, onProjectSaved, studio);
 }
 
 static void setCoverImage(Studio* studio)
@@ -1544,73 +1546,61 @@ static void setCoverImage(Studio* studio)
     }
 }
 
-static void stopVideoRecord(Studio* studio, const char* name)
+static void stopVideoRecord(Studio* studio)
 {
-    if(studio->video.buffer)
+    if(studio->video.recorder)
     {
-        {
-            s32 size = 0;
-            u8* data = malloc(FRAME_SIZE * studio->video.frame);
-            s32 i = 0;
-            char filename[TICNAME_MAX];
-
-            gif_write_animation(data, &size, TIC80_FULLWIDTH, TIC80_FULLHEIGHT, (const u8*)studio->video.buffer, studio->video.frame, TIC80_FRAMERATE, getConfig(studio)->gifScale);
+        const char* filename = studio->video.filename;
 
-            // Find an available filename to save.
-            do
-            {
-                snprintf(filename, sizeof filename, name, ++i);
-            }
-            while(tic_fs_exists(studio->fs, filename));
-
-            // Now that it has found an available filename, save it.
-            if(tic_fs_save(studio->fs, filename, data, size, true))
-            {
-                char msg[TICNAME_MAX];
-                sprintf(msg, "%s saved :)", filename);
-                showPopupMessage(studio, msg);
+        if(tic_recorder_close(studio->video.recorder))
+        {
+            char msg[TICNAME_MAX];
+            sprintf(msg, "%s saved :)", filename);
+            showPopupMessage(studio, msg);
 
-                tic_sys_open_path(tic_fs_path(studio->fs, filename));
-            }
-            else showPopupMessage(studio, "error: file not saved :(");
+            tic_sys_open_path(tic_fs_path(studio->fs, filename));
         }
+        else showPopupMessage(studio, "error: file not saved :(");
 
-        free(studio->video.buffer);
-        studio->video.buffer = NULL;
+        studio->video.recorder = NULL;
     }
-
-    studio->video.record = false;
 }
 
-static void startVideoRecord(Studio* studio)
+static void startRecord(Studio* studio, const char* name, s32 frames)
 {
-    if(studio->video.record)
+    s32 i = 0;
+
+    // Find an available filename to save.
+    do
     {
-        stopVideoRecord(studio, VideoGif);
+        snprintf(studio->video.filename, sizeof studio->video.filename, name, ++i);
     }
-    else
-    {
-        studio->video.frames = getConfig(studio)->gifLength * TIC80_FRAMERATE;
-        studio->video.buffer = malloc(FRAME_SIZE * studio->video.frames);
+    while(tic_fs_exists(studio->fs, studio->video.filename));
 
-        if(studio->video.buffer)
-        {
-            studio->video.record = true;
-            studio->video.frame = 0;
-        }
+    studio->video.recorder = tic_recorder_create(tic_fs_path(studio->fs, studio->video.filename), 
+        TIC80_FULLWIDTH, TIC80_FULLHEIGHT, getConfig(studio)->gifScale);
+
+    if(studio->video.recorder)
+    {
+        studio->video.frames = frames;
+        studio->video.frame = 0;
     }
+    else showPopupMessage(studio, "error: file not saved :(");
 }
 
-static void takeScreenshot(Studio* studio)
+static void startVideoRecord(Studio* studio)
 {
-    studio->video.frames = 1;
-    studio->video.buffer = malloc(FRAME_SIZE);
-
-    if(studio->video.buffer)
+    if(studio->video.recorder)
     {
-        studio->video.record = true;
-        studio->video.frame = 0;
+        stopVideoRecord(studio);
     }
+    else startRecord(studio, VideoGif, getConfig(studio)->gifLength * TIC80_FRAMERATE);
+}
+
+static void takeScreenshot(Studio* studio)
+{
+    if(!studio->video.recorder)
+        startRecord(studio, ScreenGif, 1);
 }
 #endif
 
@@ -1785,6 +1775,10 @@ static void checkChanges(Studio* studio)
         {
             Console* console = studio->console;
 
+            // our own save, the date is updated when it's reported
+            if(console->saves)
+                break;
+
             u64 date = fs_date(console->rom.path);
 
             if(studio->cart.mdate && date > studio->cart.mdate)
@@ -1825,17 +1819,16 @@ static void drawRecordLabel(Studio* studio, u32* frame, s32 sx, s32 sy)
 
 static bool isRecordFrame(Studio* studio)
 {
-    return studio->video.record;
+    return studio->video.recorder != NULL;
 }
 
 static void recordFrame(Studio* studio, u32* pixels)
 {
-    if(studio->video.record)
+    if(studio->video.recorder)
     {
         if(studio->video.frame < studio->video.frames)
         {
-            tic_rect rect = {0, 0, TIC80_FULLWIDTH, TIC80_FULLHEIGHT};
-            screen2buffer(studio->video.buffer + (TIC80_FULLWIDTH*TIC80_FULLHEIGHT) * studio->video.frame, pixels, &rect);
+            tic_recorder_frame(studio->video.recorder, pixels);
 
             if(studio->video.frame % TIC80_FRAMERATE < TIC80_FRAMERATE / 2)
             {
@@ -1847,7 +1840,7 @@ static void recordFrame(Studio* studio, u32* pixels)
         }
         else
         {
-            stopVideoRecord(studio, studio->video.frame == 1 ? ScreenGif : VideoGif);
+            stopVideoRecord(studio);
         }
     }
 }
@@ -2192,6 +2185,8 @@ void studio_delete(Studio* studio)
 {
     {
 #if defined(BUILD_EDITORS)
+        studio->console->flush(studio->console);
+
         for(s32 i = 0; i < TIC_EDITOR_BANKS; i++)
         {
             freeSprite  (studio->banks.sprite[i]);
@@ -2200,6 +2195,9 @@ void studio_delete(Studio* studio)
             freeMusic   (studio->banks.music[i]);
         }
 
+        if(studio->video.recorder)
+            tic_recorder_close(studio->video.recorder);
+
         freeCode    (studio->code);
         freeConsole (studio->console);
         freeWorld   (studio->world);
@@ -2224,7 +2222,7 @@ void studio_delete(Studio* studio)
     tic_net_close(studio->net);
 #endif
 
-    free(studio->fs);
+    tic_fs_delete(studio->fs);
     free(studio);
 }
 
@@ -2399,6 +2397,11 @@ Studio* studio_create(s32 argc, char **argv, s32 samplerate, tic80_pixel_color_f
 
     tic_fs_makedir(studio->fs, TIC_LOCAL);
     tic_fs_makedir(studio->fs, TIC_LOCAL_VERSION);
+    tic_fs_makedir(studio->fs, TIC_STORE);
+
+#if defined(BUILD_EDITORS)
+    tic_net_cache(studio->net, tic_fs_pathroot(studio->fs, TIC_CACHE), NET_CACHE_SIZE);
+#endif
     
     initConfig(studio->config, studio, studio->fs);
     initStart(studio->start, studio, args.cart);
@@ -2425,6 +2428,15 @@ Studio* studio_create(s32 argc, char **argv, s32 samplerate, tic80_pixel_color_f
     studio->config->data.soft               |= args.soft;
     studio->config->data.cli                |= args.cli;
 
+    if(args.gc)
+    {
+        static const char* GcModes[] = {"auto", "step", "gen", "off"};
+
+        for(s32 i = 0; i < COUNT_OF(GcModes); i++)
+            if(strcmp(args.gc, GcModes[i]) == 0)
+                studio->tic->gc.mode = i;
+    }
+
     if(args.cli)
         args.skip = true;
 
@@ -42,6 +42,7 @@
 #define TIC_LOCAL ".local/"
 #define TIC_LOCAL_VERSION TIC_LOCAL TIC_VERSION_HASH "/"
 #define TIC_CACHE TIC_LOCAL "cache/"
+#define TIC_STORE TIC_LOCAL "store/"
 
 #define TOOLBAR_SIZE 7
 #define STUDIO_TEXT_WIDTH (TIC_FONT_WIDTH)
@@ -78,6 +79,7 @@
     macro(cmd,          char*,  STRING,     "=<str>",   "run commands in the console")      \
     macro(keepcmd,      bool,   BOOLEAN,    "",         "re-execute commands on every run") \
     macro(version,      bool,   BOOLEAN,    "",         "print program version")            \
+    macro(gc,           char*,  STRING,     "=<str>",   "GC mode [auto|step|gen|off]")      \
     CRT_CMD_PARAM(macro)
 
 #define SHOW_TOOLTIP(STUDIO, FORMAT, ...)   \
@@ -185,7 +187,7 @@ void drawBitIcon(Studio* studio, s32 id, s32 x, s32 y, u8 color);
 
 tic_cartridge* loadPngCart(png_buffer buffer);
 void studioRomLoaded(Studio* studio);
-void studioRomSaved(Studio* studio);
+void studioRomSaved(Studio* studio, const tic_cartridge* cart);
 void studioConfigChanged(Studio* studio);
 
 void setStudioMode(Studio* studio, EditorMode mode);
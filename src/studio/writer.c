@@ -0,0 +1,280 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "writer.h"
+#include "fs.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(USE_LIBUV)
+#include <uv.h>
+#endif
+
+#define NS_IN_MS 1000000ull
+
+typedef struct
+{
+    char* path;
+    void* data;
+    s32 size;
+    u64 due;
+} Pending;
+
+struct tic_writer
+{
+    u64 delay;
+
+    Pending* items;
+    s32 count;
+    s32 capacity;
+
+#if defined(USE_LIBUV)
+    uv_thread_t thread;
+    uv_mutex_t mutex;
+    uv_cond_t cond;
+
+    bool threaded;
+    bool writing;
+    bool done;
+#endif
+};
+
+static u64 now()
+{
+#if defined(USE_LIBUV)
+    return uv_hrtime();
+#else
+    return (u64)clock() * (1000 * NS_IN_MS) / CLOCKS_PER_SEC;
+#endif
+}
+
+static inline void lock(tic_writer* writer)
+{
+#if defined(USE_LIBUV)
+    if(writer->threaded)
+        uv_mutex_lock(&writer->mutex);
+#endif
+}
+
+static inline void unlock(tic_writer* writer)
+{
+#if defined(USE_LIBUV)
+    if(writer->threaded)
+    {
+        uv_cond_broadcast(&writer->cond);
+        uv_mutex_unlock(&writer->mutex);
+    }
+#endif
+}
+
+// returns the index of the pending file due first or -1
+static s32 firstDue(const tic_writer* writer)
+{
+    s32 first = -1;
+
+    for(s32 i = 0; i < writer->count; i++)
+        if(first < 0 || writer->items[i].due < writer->items[first].due)
+            first = i;
+
+    return first;
+}
+
+static Pending takePending(tic_writer* writer, s32 index)
+{
+    Pending pending = writer->items[index];
+    writer->items[index] = writer->items[--writer->count];
+
+    return pending;
+}
+
+static void writePending(Pending* pending)
+{
+    fs_replace(pending->path, pending->data, pending->size);
+
+    free(pending->path);
+    free(pending->data);
+}
+
+#if defined(USE_LIBUV)
+
+static void writeFiles(void* arg)
+{
+    tic_writer* writer = arg;
+
+    uv_mutex_lock(&writer->mutex);
+
+    while(true)
+    {
+        s32 index = firstDue(writer);
+
+        if(index < 0)
+        {
+            if(writer->done)
+                break;
+
+            uv_cond_wait(&writer->cond, &writer->mutex);
+            continue;
+        }
+
+        u64 time = now();
+        u64 due = writer->items[index].due;
+
+        if(due > time)
+        {
+            uv_cond_timedwait(&writer->cond, &writer->mutex, due - time);
+            continue;
+        }
+
+        Pending pending = takePending(writer, index);
+        writer->writing = true;
+
+        uv_mutex_unlock(&writer->mutex);
+        writePending(&pending);
+        uv_mutex_lock(&writer->mutex);
+
+        writer->writing = false;
+        uv_cond_broadcast(&writer->cond);
+    }
+
+    uv_mutex_unlock(&writer->mutex);
+}
+
+#endif
+
+tic_writer* tic_writer_create(s32 delay)
+{
+    tic_writer* writer = calloc(1, sizeof(tic_writer));
+
+    writer->delay = delay * NS_IN_MS;
+
+#if defined(USE_LIBUV)
+    uv_mutex_init(&writer->mutex);
+    uv_cond_init(&writer->cond);
+
+    writer->threaded = uv_thread_create(&writer->thread, writeFiles, writer) == 0;
+#endif
+
+    return writer;
+}
+
+void tic_writer_write(tic_writer* writer, const char* path, const void* data, s32 size)
+{
+    void* copy = malloc(size);
+    memcpy(copy, data, size);
+
+    lock(writer);
+
+    Pending* pending = NULL;
+
+    for(s32 i = 0; i < writer->count; i++)
+        if(strcmp(writer->items[i].path, path) == 0)
+            pending = &writer->items[i];
+
+    if(pending)
+    {
+        // keep the due time, so a file changing every frame is still written every `delay` ms
+        free(pending->data);
+        pending->data = copy;
+        pending->size = size;
+    }
+    else
+    {
+        if(writer->count == writer->capacity)
+        {
+            writer->capacity = writer->capacity ? writer->capacity * 2 : 4;
+            writer->items = realloc(writer->items, writer->capacity * sizeof(Pending));
+        }
+
+        char* name = malloc(strlen(path) + 1);
+        strcpy(name, path);
+
+        writer->items[writer->count++] = (Pending){name, copy, size, now() + writer->delay};
+    }
+
+    unlock(writer);
+}
+
+void tic_writer_update(tic_writer* writer)
+{
+#if defined(USE_LIBUV)
+    if(writer->threaded)
+        return;
+#endif
+
+    for(s32 index; (index = firstDue(writer)) >= 0 && writer->items[index].due <= now();)
+    {
+        Pending pending = takePending(writer, index);
+        writePending(&pending);
+    }
+}
+
+void tic_writer_flush(tic_writer* writer)
+{
+#if defined(USE_LIBUV)
+    if(writer->threaded)
+    {
+        uv_mutex_lock(&writer->mutex);
+
+        for(s32 i = 0; i < writer->count; i++)
+            writer->items[i].due = 0;
+
+        uv_cond_broadcast(&writer->cond);
+
+        while(writer->count || writer->writing)
+            uv_cond_wait(&writer->cond, &writer->mutex);
+
+        uv_mutex_unlock(&writer->mutex);
+        return;
+    }
+#endif
+
+    while(writer->count)
+    {
+        Pending pending = takePending(writer, firstDue(writer));
+        writePending(&pending);
+    }
+}
+
+void tic_writer_delete(tic_writer* writer)
+{
+    tic_writer_flush(writer);
+
+#if defined(USE_LIBUV)
+    if(writer->threaded)
+    {
+        uv_mutex_lock(&writer->mutex);
+        writer->done = true;
+        uv_cond_broadcast(&writer->cond);
+        uv_mutex_unlock(&writer->mutex);
+
+        uv_thread_join(&writer->thread);
+    }
+
+    uv_cond_destroy(&writer->cond);
+    uv_mutex_destroy(&writer->mutex);
+#endif
+
+    free(writer->items);
+    free(writer);
+}
@@ -163,7 +163,8 @@ bool tic_project_ext(const char* name)
 
 bool tic_tool_has_ext(const char* name, const char* ext)
 {
-    return strcmp(name + strlen(name) - strlen(ext), ext) == 0;
+    size_t nameLen = strlen(name), extLen = strlen(ext);
+    return nameLen >= extLen && strcmp(name + nameLen - extLen, ext) == 0;
 }
 
 s32 tic_tool_get_track_row_sfx(const tic_track_row* row)
@@ -201,24 +202,19 @@ bool tic_tool_flat4(const void* buffer, s32 size)
 
 void tic_tool_str2buf(const char* str, s32 size, void* buf, bool flip)
 {
-    char val[] = "0x00";
-    const char* ptr = str;
-
-    for(s32 i = 0; i < size/2; i++)
+    static const u8 Hex[256] = 
     {
-        if(flip)
-        {
-            val[3] = *ptr++;
-            val[2] = *ptr++;
-        }
-        else
-        {
-            val[2] = *ptr++;
-            val[3] = *ptr++;
-        }
+        ['0'] = 0x0, ['1'] = 0x1, ['2'] = 0x2, ['3'] = 0x3, ['4'] = 0x4,
+        ['5'] = 0x5, ['6'] = 0x6, ['7'] = 0x7, ['8'] = 0x8, ['9'] = 0x9,
+        ['a'] = 0xa, ['b'] = 0xb, ['c'] = 0xc, ['d'] = 0xd, ['e'] = 0xe, ['f'] = 0xf,
+        ['A'] = 0xa, ['B'] = 0xb, ['C'] = 0xc, ['D'] = 0xd, ['E'] = 0xe, ['F'] = 0xf,
+    };
 
-        ((u8*)buf)[i] = (u8)strtol(val, NULL, 16);
-    }
+    const u8* ptr = (const u8*)str;
+    const s32 hi = flip ? 1 : 0, lo = flip ? 0 : 1;
+
+    for(s32 i = 0; i < size/2; i++, ptr += 2)
+        ((u8*)buf)[i] = Hex[ptr[hi]] << 4 | Hex[ptr[lo]];
 }
 
 u32 tic_tool_zip(void* dest, s32 destSize, const void* source, s32 size)